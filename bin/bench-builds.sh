@@ -0,0 +1,28 @@
+# Compares a debug build (as bin/build-compile.sh makes it) against the
+# release build from bin/build.sh, which has to be built first. Prints a
+# markdown table of headless ticks per second and the simulation's share of
+# a frame, one tick, in ms.
+set -e
+
+RELEASE=build/sewer-cleanup/sewer-cleanup
+DEBUG=build/bench/sewer-cleanup-debug
+TICKS=${TICKS:-2000}
+
+mkdir -p build/bench
+gcc src/sewer-cleanup.c -o "$DEBUG" `pkg-config --cflags --libs sdl3` -Wl,-rpath='$ORIGIN/../sewer-cleanup/lib' -g -Wall $CFLAGS
+
+ticksPerSecond() {
+    "$1" --headless --ticks "$TICKS" --characters "$2" $3 2>&1 | sed -n 's/.*Headless total: .*, \([0-9]*\) ticks\/s.*/\1/p'
+}
+
+echo "| characters | threads | debug ticks/s | release ticks/s | speedup | debug ms/tick | release ms/tick |"
+echo "|---:|---:|---:|---:|---:|---:|---:|"
+for threads in 1 0; do
+    for characters in 100 1000 10000 100000; do
+        debug=$(ticksPerSecond "$DEBUG" "$characters" "--threads $threads")
+        release=$(ticksPerSecond "$RELEASE" "$characters" "--threads $threads")
+        awk -v c="$characters" -v t="$threads" -v d="$debug" -v r="$release" 'BEGIN {
+            printf "| %d | %s | %d | %d | %.2fx | %.3f | %.3f |\n", c, t == 0 ? "all" : t, d, r, r / d, 1000 / d, 1000 / r
+        }'
+    done
+done
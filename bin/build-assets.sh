@@ -0,0 +1,5 @@
+mkdir -p build/sewer-cleanup/assets/levels
+for level in levels/*.txt; do
+    ./build/sewer-cleanup/sewer-cleanup --compile-level "$level" "build/sewer-cleanup/assets/levels/$(basename "$level" .txt).sclvl"
+done
+./build/sewer-cleanup/sewer-cleanup --pack-atlas sprites build/sewer-cleanup/assets/sprites.scat
@@ -0,0 +1,42 @@
+# The shipped binary: -O3 and LTO, with profile-guided optimization trained
+# by replaying recorded sessions headlessly.
+#
+# GCC names profile files after the output, so the instrumented build and
+# the final one are both build/sewer-cleanup/sewer-cleanup. Code the
+# training never reaches, like rendering, is still optimized for speed
+# (-fprofile-partial-training) rather than size.
+set -e
+
+OUT=build/sewer-cleanup/sewer-cleanup
+PGO=build/pgo
+SDL=`pkg-config --cflags --libs sdl3`
+RELEASE_FLAGS="-O3 -flto=auto -Wall"
+TRAINING_TICKS=${TRAINING_TICKS:-3000}
+TRAINING_CHARACTERS=${TRAINING_CHARACTERS:-2000}
+
+rm -rf "$PGO"
+mkdir -p "$PGO/profile" "$PGO/levels"
+
+gcc src/sewer-cleanup.c -o "$OUT" $SDL -Wl,-rpath='$ORIGIN/lib' $RELEASE_FLAGS $CFLAGS \
+    -fprofile-generate -fprofile-dir="$PWD/$PGO/profile" -fprofile-update=prefer-atomic
+
+# One session per level, recorded with the headless script driving every
+# character. Only the replays count towards the profile.
+for level in levels/*.txt; do
+    name=$(basename "$level" .txt)
+    "$OUT" --compile-level "$level" "$PGO/levels/$name.sclvl"
+    "$OUT" --headless --ticks "$TRAINING_TICKS" --characters "$TRAINING_CHARACTERS" \
+        --level "$PGO/levels/$name.sclvl" --record "$PGO/$name.scrp"
+done
+rm -rf "$PGO/profile"
+mkdir -p "$PGO/profile"
+
+for level in levels/*.txt; do
+    name=$(basename "$level" .txt)
+    for dispatch in direct batch predicted; do
+        "$OUT" --replay "$PGO/$name.scrp" --level "$PGO/levels/$name.sclvl" --dispatch "$dispatch"
+    done
+done
+
+gcc src/sewer-cleanup.c -o "$OUT" $SDL -Wl,-rpath='$ORIGIN/lib' $RELEASE_FLAGS $CFLAGS \
+    -fprofile-use -fprofile-dir="$PWD/$PGO/profile" -fprofile-partial-training -Wno-missing-profile
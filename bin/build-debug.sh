@@ -0,0 +1,4 @@
+./bin/build-clean.sh
+./bin/build-prep.sh
+./bin/build-compile.sh
+./bin/build-assets.sh
@@ -1,4 +1,5 @@
 ./bin/build-clean.sh
 ./bin/build-prep.sh
-./bin/build-compile.sh
+./bin/build-compile-release.sh
+./bin/build-assets.sh
 ./bin/build-release.sh
@@ -0,0 +1,139 @@
+#include <SDL3/SDL.h>
+#include "types.h"
+
+// Linear allocators. Every SC_AppState has two: `arena` holds everything
+// that lives as long as the app state, `frame` holds scratch memory that's
+// thrown away at the end of each step and frame. Allocating is a pointer
+// bump, and nothing is freed on its own, only the whole arena at once.
+//
+// Running out of room allocates another chunk rather than failing. Chunks
+// are what shows up as heap allocations: a frame arena folds its chunks
+// into one big enough for its high-water mark when it's reset, so after the
+// first few frames it never allocates again.
+
+struct SC_ArenaChunk {
+    SC_ArenaChunk *prev;
+    size_t size; // Of data
+    size_t used;
+    Uint8 *data;
+};
+
+// Chunk header and data share one allocation, data starting SC_ARENA_ALIGN
+// bytes in
+#define SC_ARENA_HEADER SC_ARENA_ALIGN
+
+static size_t arenaAlign(size_t size)
+{
+    return (size + SC_ARENA_ALIGN - 1) & ~((size_t) SC_ARENA_ALIGN - 1);
+}
+
+static bool addArenaChunk(SC_Arena *a, size_t size)
+{
+    size = arenaAlign(size);
+    SC_ArenaChunk *chunk = SDL_aligned_alloc(SC_ARENA_ALIGN, SC_ARENA_HEADER + size);
+    if (chunk == NULL) {
+        SDL_Log("Arena %s: failed to allocate %zu bytes", a->name, size);
+        return false;
+    }
+
+    chunk->prev = a->chunk;
+    chunk->size = size;
+    chunk->used = 0;
+    chunk->data = (Uint8 *) chunk + SC_ARENA_HEADER;
+    a->chunk = chunk;
+    a->size += size;
+    a->numChunks++;
+    a->heapAllocs++;
+    return true;
+}
+
+static void freeArenaChunks(SC_Arena *a)
+{
+    while (a->chunk != NULL) {
+        SC_ArenaChunk *prev = a->chunk->prev;
+        SDL_aligned_free(a->chunk);
+        a->chunk = prev;
+    }
+    a->size = 0;
+    a->numChunks = 0;
+}
+
+// `size` is the first chunk, a good guess saves growing it later
+bool initArena(SC_Arena *a, const char *name, size_t size)
+{
+    SDL_zerop(a);
+    a->name = name;
+    return addArenaChunk(a, size);
+}
+
+void destroyArena(SC_Arena *a)
+{
+    freeArenaChunks(a);
+    SDL_zerop(a);
+}
+
+// Returns `size` bytes starting on a SC_ARENA_ALIGN boundary, or NULL if
+// the arena is out of room and no more memory can be had
+void *arenaAlloc(SC_Arena *a, size_t size)
+{
+    size = arenaAlign(size);
+
+    // A new chunk at least doubles the arena, so growing step by step
+    // still only takes a handful of chunks
+    if (a->chunk == NULL || a->chunk->size - a->chunk->used < size) {
+        if (!addArenaChunk(a, SDL_max(size, a->size))) {
+            return NULL;
+        }
+    }
+
+    void *p = a->chunk->data + a->chunk->used;
+    a->chunk->used += size;
+    a->used += size;
+    a->highWater = SDL_max(a->highWater, a->used);
+    return p;
+}
+
+SC_ArenaMark arenaMark(const SC_Arena *a)
+{
+    return (SC_ArenaMark) {
+        .chunk = a->chunk,
+        .chunkUsed = a->chunk != NULL ? a->chunk->used : 0,
+        .used = a->used,
+    };
+}
+
+// Gives back everything allocated since `mark`. Chunks added since stay
+// until the next reset.
+void arenaRewind(SC_Arena *a, SC_ArenaMark mark)
+{
+    if (a->chunk == mark.chunk && mark.chunk != NULL) {
+        a->chunk->used = mark.chunkUsed;
+        a->used = mark.used;
+    }
+}
+
+// Gives back everything. More than one chunk means the arena outgrew its
+// first one, so they're replaced by a single chunk that fits the high-water
+// mark.
+void arenaReset(SC_Arena *a)
+{
+    if (a->numChunks > 1) {
+        freeArenaChunks(a);
+        addArenaChunk(a, a->highWater);
+    }
+    if (a->chunk != NULL) {
+        a->chunk->used = 0;
+    }
+    a->used = 0;
+}
+
+void logArena(const SC_Arena *a)
+{
+    SDL_Log("Arena %s: %.1f KiB high water, %.1f KiB in use, %.1f KiB in %u chunks, %" SDL_PRIu64 " heap allocations",
+        a->name,
+        (double) a->highWater / 1024.0,
+        (double) a->used / 1024.0,
+        (double) a->size / 1024.0,
+        a->numChunks,
+        a->heapAllocs);
+}
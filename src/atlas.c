@@ -0,0 +1,283 @@
+#include <SDL3/SDL.h>
+#include "types.h"
+#include "fsm.h"
+
+// Every sprite lives in one texture, so a whole layer of sprites is one
+// SDL_RenderGeometry call with no texture switches. The atlas is packed at
+// build time (--pack-atlas) from one BMP per frame and loaded with a single
+// file read.
+//
+// Sources are sprites/character/<Name>.bmp for each state in
+// CHARACTER_STATES, drawn facing right and standing on the bottom middle
+// pixel. The left facing frames are packed as mirror images, so a sprite is
+// looked up by state and facing alone.
+//
+// File layout, native byte order (only little endian hosts load atlases):
+//   SC_AtlasHeader
+//   rects   SC_AtlasRect[numSprites], indexed by SC_SPRITE_CHARACTER()
+//   pixels  width * height SDL_PIXELFORMAT_RGBA32
+
+#define SC_ATLAS_MAGIC   0x54414353 // "SCAT"
+#define SC_ATLAS_VERSION 1
+
+// Gap between frames, so linear filtering never bleeds a neighbour in
+#define SC_ATLAS_PADDING 1
+
+#define SC_SPRITE_CHARACTER(state, flags) ((state) * 2 + ((flags) & CHARACTER_FLAG_FACE_RIGHT))
+#define SC_SPRITE_TOTAL (SC_CHARACTER_MOVE_STATE_TOTAL * 2)
+
+typedef struct SC_AtlasHeader {
+    Uint32 magic;
+    Uint32 version;
+    Uint32 width;
+    Uint32 height;
+    Uint32 numSprites;
+} SC_AtlasHeader;
+
+typedef struct SC_AtlasRect {
+    Uint16 x;
+    Uint16 y;
+    Uint16 w;
+    Uint16 h;
+} SC_AtlasRect;
+
+typedef struct SC_Atlas {
+    SDL_Texture *texture;
+    SDL_FRect uv[SC_SPRITE_TOTAL];      // In texture coordinates
+    SDL_FPoint size[SC_SPRITE_TOTAL];   // In pixels
+} SC_Atlas;
+
+// In SC_Character_State order
+static const char *characterSpriteNames[] = {
+#define CHARACTER_SPRITE_NAME(id, name, x, y) #name,
+    CHARACTER_STATES(CHARACTER_SPRITE_NAME)
+#undef CHARACTER_SPRITE_NAME
+};
+
+void destroyAtlas(SC_Atlas *a)
+{
+    SDL_DestroyTexture(a->texture);
+    SDL_zerop(a);
+}
+
+// Loads a packed atlas into a texture. On failure `a` has no texture.
+bool loadAtlas(SC_Atlas *a, SDL_Renderer *renderer, const char *path)
+{
+    destroyAtlas(a);
+
+    size_t size;
+    Uint8 *data = SDL_LoadFile(path, &size);
+    if (data == NULL) {
+        SDL_Log("Failed to load %s: %s", path, SDL_GetError());
+        return false;
+    }
+
+    const SC_AtlasHeader *h = (const SC_AtlasHeader *) data;
+    size_t rectsSize = SC_SPRITE_TOTAL * sizeof(SC_AtlasRect);
+    if (SDL_BYTEORDER != SDL_LIL_ENDIAN || size < sizeof(SC_AtlasHeader) + rectsSize
+        || h->magic != SC_ATLAS_MAGIC || h->version != SC_ATLAS_VERSION || h->numSprites != SC_SPRITE_TOTAL
+        || h->width == 0 || h->width > SDL_MAX_UINT16 || h->height == 0 || h->height > SDL_MAX_UINT16
+        || size - sizeof(SC_AtlasHeader) - rectsSize != (size_t) h->width * h->height * 4) {
+        SDL_Log("%s is not a version %d atlas for this build", path, SC_ATLAS_VERSION);
+        SDL_free(data);
+        return false;
+    }
+
+    const SC_AtlasRect *rects = (const SC_AtlasRect *) (data + sizeof(SC_AtlasHeader));
+    for (int k = 0; k < SC_SPRITE_TOTAL; k++) {
+        const SC_AtlasRect *r = &rects[k];
+        if (r->x + r->w > h->width || r->y + r->h > h->height) {
+            SDL_Log("%s: sprite %d is outside the atlas", path, k);
+            SDL_free(data);
+            return false;
+        }
+        a->uv[k] = (SDL_FRect) {
+            (float) r->x / h->width,
+            (float) r->y / h->height,
+            (float) r->w / h->width,
+            (float) r->h / h->height,
+        };
+        a->size[k] = (SDL_FPoint) { (float) r->w, (float) r->h };
+    }
+
+    a->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, (int) h->width, (int) h->height);
+    if (a->texture == NULL || !SDL_UpdateTexture(a->texture, NULL, rects + SC_SPRITE_TOTAL, (int) h->width * 4)) {
+        SDL_Log("Failed to create atlas texture: %s", SDL_GetError());
+        SDL_free(data);
+        destroyAtlas(a);
+        return false;
+    }
+    SDL_SetTextureScaleMode(a->texture, SDL_SCALEMODE_NEAREST);
+
+    SDL_free(data);
+    return true;
+}
+
+// PACKING
+
+typedef struct SC_AtlasFrame {
+    SDL_Surface *surface; // RGBA32
+    bool mirror;
+    int sprite;
+} SC_AtlasFrame;
+
+// Tallest first, so each shelf wastes as little height as possible
+static int compareFrameHeight(const void *a, const void *b)
+{
+    const SC_AtlasFrame *x = a;
+    const SC_AtlasFrame *y = b;
+    if (x->surface->h != y->surface->h) {
+        return y->surface->h - x->surface->h;
+    }
+    return x->sprite - y->sprite;
+}
+
+// Shelf packs `frames` into rows `width` wide. Returns the height used, or
+// 0 if a frame is wider than the atlas.
+static int shelfPack(const SC_AtlasFrame *frames, int n, int width, SC_AtlasRect *rects)
+{
+    int x = 0;
+    int y = 0;
+    int shelf = 0;
+
+    for (int k = 0; k < n; k++) {
+        int w = frames[k].surface->w;
+        int h = frames[k].surface->h;
+        if (w > width) {
+            return 0;
+        }
+        if (x + w > width) {
+            x = 0;
+            y += shelf + SC_ATLAS_PADDING;
+            shelf = 0;
+        }
+
+        rects[frames[k].sprite] = (SC_AtlasRect) { (Uint16) x, (Uint16) y, (Uint16) w, (Uint16) h };
+        x += w + SC_ATLAS_PADDING;
+        shelf = SDL_max(shelf, h);
+    }
+
+    return y + shelf;
+}
+
+// Copies `frame` into the atlas pixels at `r`, flipped left to right if it
+// is a mirrored one
+static void blitFrame(const SC_AtlasFrame *frame, const SC_AtlasRect *r, Uint32 *pixels, int width)
+{
+    const SDL_Surface *s = frame->surface;
+    for (int y = 0; y < s->h; y++) {
+        const Uint32 *src = (const Uint32 *) ((const Uint8 *) s->pixels + y * s->pitch);
+        Uint32 *dst = pixels + (r->y + y) * width + r->x;
+        for (int x = 0; x < s->w; x++) {
+            dst[x] = src[frame->mirror ? s->w - 1 - x : x];
+        }
+    }
+}
+
+static void destroyFrames(SC_AtlasFrame *frames)
+{
+    // Mirrored frames share the surface of the right facing one
+    for (int state = 0; state < SC_CHARACTER_MOVE_STATE_TOTAL; state++) {
+        SDL_DestroySurface(frames[SC_SPRITE_CHARACTER(state, CHARACTER_FLAG_FACE_RIGHT)].surface);
+    }
+}
+
+static bool loadFrames(SC_AtlasFrame *frames, const char *spriteDir)
+{
+    for (int state = 0; state < SC_CHARACTER_MOVE_STATE_TOTAL; state++) {
+        char path[512];
+        SDL_snprintf(path, sizeof(path), "%s/character/%s.bmp", spriteDir, characterSpriteNames[state]);
+
+        SDL_Surface *loaded = SDL_LoadBMP(path);
+        if (loaded == NULL) {
+            SDL_Log("Failed to load %s: %s", path, SDL_GetError());
+            return false;
+        }
+        SDL_Surface *surface = SDL_ConvertSurface(loaded, SDL_PIXELFORMAT_RGBA32);
+        SDL_DestroySurface(loaded);
+        if (surface == NULL || surface->w > SDL_MAX_UINT16 || surface->h > SDL_MAX_UINT16) {
+            SDL_Log("Failed to convert %s", path);
+            SDL_DestroySurface(surface);
+            return false;
+        }
+
+        int right = SC_SPRITE_CHARACTER(state, CHARACTER_FLAG_FACE_RIGHT);
+        int left = SC_SPRITE_CHARACTER(state, 0);
+        frames[right] = (SC_AtlasFrame) { surface, false, right };
+        frames[left] = (SC_AtlasFrame) { surface, true, left };
+    }
+
+    return true;
+}
+
+static bool writeAtlas(const char *outPath, const SC_AtlasHeader *h, const SC_AtlasRect *rects, const Uint32 *pixels)
+{
+    SDL_IOStream *out = SDL_IOFromFile(outPath, "wb");
+    if (out == NULL) {
+        SDL_Log("Failed to open %s: %s", outPath, SDL_GetError());
+        return false;
+    }
+
+    size_t rectsSize = SC_SPRITE_TOTAL * sizeof(SC_AtlasRect);
+    size_t pixelsSize = (size_t) h->width * h->height * 4;
+    bool ok = SDL_WriteIO(out, h, sizeof(*h)) == sizeof(*h)
+        && SDL_WriteIO(out, rects, rectsSize) == rectsSize
+        && SDL_WriteIO(out, pixels, pixelsSize) == pixelsSize;
+    ok = SDL_CloseIO(out) && ok;
+    if (!ok) {
+        SDL_Log("Failed to write %s: %s", outPath, SDL_GetError());
+    }
+    return ok;
+}
+
+// --pack-atlas
+bool packAtlas(const char *spriteDir, const char *outPath)
+{
+    SC_AtlasFrame frames[SC_SPRITE_TOTAL] = { 0 };
+    if (!loadFrames(frames, spriteDir)) {
+        destroyFrames(frames);
+        return false;
+    }
+
+    SC_AtlasFrame order[SC_SPRITE_TOTAL];
+    SDL_memcpy(order, frames, sizeof(order));
+    SDL_qsort(order, SC_SPRITE_TOTAL, sizeof(SC_AtlasFrame), compareFrameHeight);
+
+    // The narrowest power of two that packs no taller than it is wide
+    SC_AtlasRect rects[SC_SPRITE_TOTAL];
+    int width = 64;
+    int height = 0;
+    while (width <= SDL_MAX_UINT16) {
+        height = shelfPack(order, SC_SPRITE_TOTAL, width, rects);
+        if (height > 0 && height <= width) {
+            break;
+        }
+        width *= 2;
+    }
+
+    Uint32 *pixels = width <= SDL_MAX_UINT16 ? SDL_calloc((size_t) width * height, 4) : NULL;
+    if (pixels == NULL) {
+        SDL_Log("Sprites don't fit in an atlas");
+        destroyFrames(frames);
+        return false;
+    }
+    for (int k = 0; k < SC_SPRITE_TOTAL; k++) {
+        blitFrame(&frames[k], &rects[k], pixels, width);
+    }
+    destroyFrames(frames);
+
+    SC_AtlasHeader h = {
+        .magic = SC_ATLAS_MAGIC,
+        .version = SC_ATLAS_VERSION,
+        .width = (Uint32) width,
+        .height = (Uint32) height,
+        .numSprites = SC_SPRITE_TOTAL,
+    };
+    bool ok = writeAtlas(outPath, &h, rects, pixels);
+    if (ok) {
+        SDL_Log("Packed %d sprites into %s, %dx%d", SC_SPRITE_TOTAL, outPath, width, height);
+    }
+
+    SDL_free(pixels);
+    return ok;
+}
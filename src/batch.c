@@ -0,0 +1,151 @@
+#include <SDL3/SDL.h>
+
+// Collects rects, lines and sprites into one vertex and index buffer, with
+// the color stored per vertex, so a whole layer is drawn by a single
+// SDL_RenderGeometry call instead of one call per primitive. The buffers
+// grow as needed and are reused from frame to frame.
+
+typedef struct SC_RenderBatch {
+    SDL_Texture *texture; // Sprites sample it; NULL for flat colored layers
+    SDL_Vertex *vertices;
+    int *indices;
+    int numVertices;
+    int numIndices;
+    int capVertices; // Indices always have room for capVertices / 4 * 6
+} SC_RenderBatch;
+
+void initRenderBatch(SC_RenderBatch *b)
+{
+    SDL_zerop(b);
+}
+
+void destroyRenderBatch(SC_RenderBatch *b)
+{
+    SDL_free(b->vertices);
+    SDL_free(b->indices);
+    SDL_zerop(b);
+}
+
+static bool reserveRenderBatch(SC_RenderBatch *b, int numQuads)
+{
+    int needed = b->numVertices + numQuads * 4;
+    if (needed <= b->capVertices) {
+        return true;
+    }
+
+    int cap = b->capVertices > 0 ? b->capVertices : 256;
+    while (cap < needed) {
+        cap *= 2;
+    }
+
+    SDL_Vertex *vertices = SDL_realloc(b->vertices, cap * sizeof(SDL_Vertex));
+    if (vertices == NULL) {
+        return false;
+    }
+    b->vertices = vertices;
+
+    int *indices = SDL_realloc(b->indices, cap / 4 * 6 * sizeof(int));
+    if (indices == NULL) {
+        return false;
+    }
+    b->indices = indices;
+
+    b->capVertices = cap;
+    return true;
+}
+
+// Corners in order around the quad, with texture coordinates to match or
+// NULL for none
+static void batchQuad(SC_RenderBatch *b, const SDL_FPoint corners[4], const SDL_FPoint uv[4], SDL_FColor color)
+{
+    if (!reserveRenderBatch(b, 1)) {
+        return;
+    }
+
+    int base = b->numVertices;
+    for (int k = 0; k < 4; k++) {
+        b->vertices[base + k] = (SDL_Vertex) { corners[k], color, uv != NULL ? uv[k] : (SDL_FPoint) { 0.0f, 0.0f } };
+    }
+    b->numVertices += 4;
+
+    int *idx = b->indices + b->numIndices;
+    idx[0] = base;
+    idx[1] = base + 1;
+    idx[2] = base + 2;
+    idx[3] = base;
+    idx[4] = base + 2;
+    idx[5] = base + 3;
+    b->numIndices += 6;
+}
+
+void batchRect(SC_RenderBatch *b, const SDL_FRect *r, SDL_FColor color)
+{
+    SDL_FPoint corners[4] = {
+        { r->x,        r->y },
+        { r->x + r->w, r->y },
+        { r->x + r->w, r->y + r->h },
+        { r->x,        r->y + r->h },
+    };
+    batchQuad(b, corners, NULL, color);
+}
+
+// `src` of the batch's texture, in texture coordinates, drawn over `dst`
+void batchSprite(SC_RenderBatch *b, const SDL_FRect *dst, const SDL_FRect *src)
+{
+    SDL_FPoint corners[4] = {
+        { dst->x,          dst->y },
+        { dst->x + dst->w, dst->y },
+        { dst->x + dst->w, dst->y + dst->h },
+        { dst->x,          dst->y + dst->h },
+    };
+    SDL_FPoint uv[4] = {
+        { src->x,          src->y },
+        { src->x + src->w, src->y },
+        { src->x + src->w, src->y + src->h },
+        { src->x,          src->y + src->h },
+    };
+    batchQuad(b, corners, uv, (SDL_FColor) { 1.0f, 1.0f, 1.0f, 1.0f });
+}
+
+// A one pixel wide line through the centers of the pixels SDL_RenderLine
+// would light up
+void batchLine(SC_RenderBatch *b, float x1, float y1, float x2, float y2, SDL_FColor color)
+{
+    float dx = x2 - x1;
+    float dy = y2 - y1;
+    float len = SDL_sqrtf(dx * dx + dy * dy);
+    if (len == 0.0f) {
+        SDL_FRect dot = { x1, y1, 1.0f, 1.0f };
+        batchRect(b, &dot, color);
+        return;
+    }
+
+    // Half a pixel out to each side, and half a pixel past each end
+    float nx = -dy / len * 0.5f;
+    float ny = dx / len * 0.5f;
+    float ex = dx / len * 0.5f;
+    float ey = dy / len * 0.5f;
+    x1 += 0.5f - ex;
+    y1 += 0.5f - ey;
+    x2 += 0.5f + ex;
+    y2 += 0.5f + ey;
+
+    SDL_FPoint corners[4] = {
+        { x1 + nx, y1 + ny },
+        { x2 + nx, y2 + ny },
+        { x2 - nx, y2 - ny },
+        { x1 - nx, y1 - ny },
+    };
+    batchQuad(b, corners, NULL, color);
+}
+
+// Draws everything collected so far in one call and empties the batch
+void flushRenderBatch(SDL_Renderer *renderer, SC_RenderBatch *b)
+{
+    if (b->numIndices > 0) {
+        SDL_RenderGeometry(renderer, b->texture, b->vertices, b->numVertices, b->indices, b->numIndices);
+    }
+
+    b->numVertices = 0;
+    b->numIndices = 0;
+}
@@ -0,0 +1,261 @@
+#include <SDL3/SDL.h>
+#include "types.h"
+
+// Benchmarks run from SDL_AppInit and exit. They reuse the headless input
+// script so characters are spread across states the same way.
+
+#define BENCH_CHARACTER_TICKS 20000000
+#define BENCH_MIN_TICKS       1000
+#define BENCH_WARMUP_TICKS    HEADLESS_SCRIPT_PERIOD
+
+#define BENCH_THREADS_CHARACTERS 100000
+
+static const Uint32 benchSizes[] = { 10, 1000, 100000 };
+
+// Runs the scripted simulation and returns the time spent in tick() in ns
+// per character-tick. The final state checksum is written to *crc, 0 if
+// the state couldn't be made.
+double benchRun(Uint32 numCharacters, SC_DispatchMode mode, SC_Workers *workers, Uint32 *crc)
+{
+    SC_AppState *s = initAppState(0, numCharacters);
+    if (s == NULL) {
+        *crc = 0;
+        return 0.0;
+    }
+    s->dispatchMode = mode;
+    s->workers = workers;
+
+    Uint64 ticks = SDL_max(BENCH_CHARACTER_TICKS / numCharacters, BENCH_MIN_TICKS);
+    Uint64 now = s->prevTick;
+    Uint64 elapsed = 0;
+
+    for (Uint64 t = 0; t < BENCH_WARMUP_TICKS + ticks; t++) {
+        headlessScriptStep(s, 0, now);
+        now += FIXED_TICK_RATE;
+
+        Uint64 start = SDL_GetPerformanceCounter();
+        tick(s, now);
+        if (t >= BENCH_WARMUP_TICKS) {
+            elapsed += SDL_GetPerformanceCounter() - start;
+        }
+    }
+
+    *crc = checksumCharacters(&s->characters);
+    destroyAppState(s);
+
+    double ns = (double) elapsed * 1e9 / (double) SDL_GetPerformanceFrequency();
+    return ns / ((double) ticks * numCharacters);
+}
+
+void benchDispatch()
+{
+    headlessScriptInit();
+
+    SDL_Log("Dispatch benchmark, ns per character-tick (tick() only)");
+    SDL_Log("%10s %10s %10s %8s %10s %8s %6s", "characters", "direct", "batch", "speedup", "predicted", "speedup", "match");
+
+    for (Uint32 k = 0; k < SDL_arraysize(benchSizes); k++) {
+        Uint32 crcDirect;
+        Uint32 crcBatch;
+        Uint32 crcPredicted;
+        double direct = benchRun(benchSizes[k], SC_DISPATCH_DIRECT, NULL, &crcDirect);
+        double batch = benchRun(benchSizes[k], SC_DISPATCH_BATCH, NULL, &crcBatch);
+        double predicted = benchRun(benchSizes[k], SC_DISPATCH_PREDICTED, NULL, &crcPredicted);
+
+        SDL_Log("%10u %10.2f %10.2f %7.2fx %10.2f %7.2fx %6s",
+            benchSizes[k],
+            direct,
+            batch,
+            batch > 0.0 ? direct / batch : 0.0,
+            predicted,
+            predicted > 0.0 ? direct / predicted : 0.0,
+            crcDirect == crcBatch && crcDirect == crcPredicted ? "yes" : "NO");
+    }
+}
+
+// Doubles the thread count up to one per logical core. Every run has to end
+// in the same state as the single-threaded one.
+void benchThreads()
+{
+    int cores = SDL_GetNumLogicalCPUCores();
+
+    headlessScriptInit();
+
+    SDL_Log("Thread scaling benchmark, %u characters, ns per character-tick (tick() only)", BENCH_THREADS_CHARACTERS);
+    SDL_Log("%10s %10s %8s %6s", "threads", "direct", "speedup", "match");
+
+    Uint32 crcSingle = 0;
+    double single = 0.0;
+
+    for (int n = 1; n <= cores; n = (n < cores && n * 2 > cores) ? cores : n * 2) {
+        SC_Workers *workers = createWorkers(n);
+        if (workers == NULL) {
+            break;
+        }
+
+        Uint32 crc;
+        double ns = benchRun(BENCH_THREADS_CHARACTERS, SC_DISPATCH_DIRECT, workers, &crc);
+        int numThreads = workers->numThreads;
+        destroyWorkers(workers);
+
+        if (n == 1) {
+            single = ns;
+            crcSingle = crc;
+        }
+
+        SDL_Log("%10d %10.2f %7.2fx %6s",
+            numThreads,
+            ns,
+            ns > 0.0 ? single / ns : 0.0,
+            crc == crcSingle ? "yes" : "NO");
+    }
+}
+
+// The function-pointer path eventCharacter and tickCharactersDirect took
+// before the FSM was generated from tables, kept to compare against. Events
+// wake the character the same way eventCharacter does, so both sides time
+// the same work.
+static void eventCharacterIndirect(SC_Characters *c, Uint32 i, SC_Event e, Uint64 now, Uint64 opts)
+{
+    int newState = FSMsCharacter[c->state[i]].input(c, i, e, now, &opts);
+
+    if (newState != SC_FSM_NO_CHANGE) {
+        FSMsCharacter[c->state[i]].exit(c, i, &opts);
+        c->state[i] = newState;
+        FSMsCharacter[c->state[i]].enter(c, i, &opts);
+        c->wakeIn[i] = 0;
+        wakeCharacter(c, i);
+    }
+}
+
+static void tickCharactersIndirect(SC_Characters *c, Uint64 delta, Uint64 now)
+{
+    for (Uint32 i = 0; i < c->count; i++) {
+        Uint64 opts = 0;
+
+        int newState = FSMsCharacter[c->state[i]].tick(c, i, delta, now, &opts);
+
+        if (newState != SC_FSM_NO_CHANGE) {
+            FSMsCharacter[c->state[i]].exit(c, i, &opts);
+            c->state[i] = newState;
+            FSMsCharacter[c->state[i]].enter(c, i, &opts);
+        }
+    }
+}
+
+typedef struct SC_BenchFSM {
+    double tickNs;  // Per character-tick
+    double eventNs; // Per scripted event
+    Uint32 crc;
+} SC_BenchFSM;
+
+// Runs the scripted simulation one step at a time, timing only the FSM
+// input and tick passes. Working out which characters get an event,
+// integration and floors all run untimed in between.
+static SC_BenchFSM benchFSMRun(Uint32 numCharacters, bool indirect)
+{
+    SC_BenchFSM result = { 0 };
+    SC_AppState *s = initAppState(0, numCharacters);
+    Uint32 *eventIs = SDL_malloc(numCharacters * sizeof(Uint32));
+    const SC_ScriptStep **eventSteps = SDL_malloc(numCharacters * sizeof(SC_ScriptStep *));
+    if (s == NULL || eventIs == NULL || eventSteps == NULL) {
+        destroyAppState(s);
+        SDL_free(eventIs);
+        SDL_free(eventSteps);
+        return result;
+    }
+
+    SC_Characters *c = &s->characters;
+    Uint64 ticks = SDL_max(BENCH_CHARACTER_TICKS / numCharacters, BENCH_MIN_TICKS);
+    Uint64 now = 0;
+    Uint64 tickElapsed = 0;
+    Uint64 eventElapsed = 0;
+    Uint64 numEvents = 0;
+
+    for (Uint64 t = 0; t < BENCH_WARMUP_TICKS + ticks; t++) {
+        bool timed = t >= BENCH_WARMUP_TICKS;
+        Uint32 phase = s->tickCount % HEADLESS_SCRIPT_PERIOD;
+        Uint32 n = 0;
+
+        for (Uint32 i = 0; i < c->count; i++) {
+            Sint8 j = headlessScriptAt[phase];
+            if (j >= 0) {
+                eventIs[n] = i;
+                eventSteps[n] = &headlessScript[j];
+                n++;
+            }
+
+            phase += HEADLESS_SCRIPT_STAGGER;
+            if (phase >= HEADLESS_SCRIPT_PERIOD) {
+                phase -= HEADLESS_SCRIPT_PERIOD;
+            }
+        }
+
+        Uint64 start = SDL_GetPerformanceCounter();
+        for (Uint32 k = 0; k < n; k++) {
+            if (indirect) {
+                eventCharacterIndirect(c, eventIs[k], eventSteps[k]->event, now, eventSteps[k]->opts);
+            } else {
+                eventCharacter(c, eventIs[k], eventSteps[k]->event, now, eventSteps[k]->opts);
+            }
+        }
+        Uint64 end = SDL_GetPerformanceCounter();
+        if (timed) {
+            eventElapsed += end - start;
+            numEvents += n;
+        }
+
+        now += FIXED_TICK_RATE;
+        computeFloors(c, s->level, 0, c->count);
+        integrateCharacters(c, 0, c->count, FIXED_TICK_RATE, c->tuning.xVelMax, c->tuning.yVelMax);
+
+        start = SDL_GetPerformanceCounter();
+        if (indirect) {
+            tickCharactersIndirect(c, FIXED_TICK_RATE, now);
+        } else {
+            tickCharactersDirect(c, 0, c->count, FIXED_TICK_RATE, now);
+        }
+        end = SDL_GetPerformanceCounter();
+        if (timed) {
+            tickElapsed += end - start;
+        }
+
+        s->tickCount++;
+    }
+
+    result.crc = checksumCharacters(c);
+    destroyAppState(s);
+    SDL_free(eventIs);
+    SDL_free(eventSteps);
+
+    double ns = 1e9 / (double) SDL_GetPerformanceFrequency();
+    result.tickNs = tickElapsed * ns / ((double) ticks * numCharacters);
+    result.eventNs = numEvents > 0 ? eventElapsed * ns / (double) numEvents : 0.0;
+    return result;
+}
+
+// Function-pointer table against the generated switch, for FSM ticks and
+// input events
+void benchFSM()
+{
+    headlessScriptInit();
+
+    SDL_Log("FSM dispatch benchmark, ns per character-tick and per event");
+    SDL_Log("%10s %10s %10s %8s %10s %10s %8s %6s",
+        "characters", "tick ptr", "switch", "speedup", "event ptr", "switch", "speedup", "match");
+
+    for (Uint32 k = 0; k < SDL_arraysize(benchSizes); k++) {
+        SC_BenchFSM indirect = benchFSMRun(benchSizes[k], true);
+        SC_BenchFSM direct = benchFSMRun(benchSizes[k], false);
+
+        SDL_Log("%10u %10.2f %10.2f %7.2fx %10.2f %10.2f %7.2fx %6s",
+            benchSizes[k],
+            indirect.tickNs,
+            direct.tickNs,
+            direct.tickNs > 0.0 ? indirect.tickNs / direct.tickNs : 0.0,
+            indirect.eventNs,
+            direct.eventNs,
+            direct.eventNs > 0.0 ? indirect.eventNs / direct.eventNs : 0.0,
+            indirect.crc == direct.crc ? "yes" : "NO");
+    }
+}
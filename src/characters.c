@@ -0,0 +1,452 @@
+#include <SDL3/SDL.h>
+#include "types.h"
+
+typedef void (*SC_IntegrateFn)(SC_Characters *c, Uint32 begin, Uint32 end, Uint32 delta, SC_Real velMaxX, SC_Real velMaxY);
+
+// Set by selectIntegrateKernel()
+SC_IntegrateFn integrateCharacters;
+
+static size_t charactersArraySize(Uint32 capacity, size_t elSize)
+{
+    size_t size = capacity * elSize;
+    return (size + SC_CHARACTERS_ALIGN - 1) & ~((size_t) SC_CHARACTERS_ALIGN - 1);
+}
+
+// Carves the arrays for `capacity` characters out of `block` into `c`.
+// Returns the size of the block needed when `block` is NULL.
+static size_t layoutCharacters(SC_Characters *c, void *block, Uint32 capacity)
+{
+    size_t reals = charactersArraySize(capacity, sizeof(SC_Real));
+    size_t bytes = charactersArraySize(capacity, sizeof(Uint8));
+    size_t words = charactersArraySize(capacity, sizeof(Uint32));
+    size_t halves = charactersArraySize(capacity, sizeof(Uint16));
+
+    if (block != NULL) {
+        Uint8 *p = block;
+        c->posX = (SC_Real *) p; p += reals;
+        c->posY = (SC_Real *) p; p += reals;
+        c->velX = (SC_Real *) p; p += reals;
+        c->velY = (SC_Real *) p; p += reals;
+        c->accX = (SC_Real *) p; p += reals;
+        c->accY = (SC_Real *) p; p += reals;
+        c->prevX = (SC_Real *) p; p += reals;
+        c->prevY = (SC_Real *) p; p += reals;
+        c->floorY = (SC_Real *) p; p += reals;
+        c->state = p; p += bytes;
+        c->flags = p; p += bytes;
+        c->denseSlot = (Uint32 *) p; p += words;
+        c->slotDense = (Uint32 *) p; p += words;
+        c->slotGen = (Uint32 *) p; p += words;
+        c->wakeIn = (Uint16 *) p; p += halves;
+        c->schedule = (Uint32 *) p; p += words;
+        c->scheduledAt = (Uint32 *) p;
+        c->capacity = capacity;
+    }
+
+    return 9 * reals + 2 * bytes + 5 * words + halves;
+}
+
+// The arrays come out of `arena` and go away with it, there's nothing to
+// destroy
+bool initCharacters(SC_Characters *c, SC_Arena *arena, Uint32 capacity)
+{
+    SDL_zerop(c);
+    c->freeSlot = SC_SLOT_NONE;
+    c->tuning = characterTuningDefault;
+    c->arena = arena;
+
+    size_t size = layoutCharacters(c, NULL, capacity);
+    void *block = arenaAlloc(arena, size);
+    if (block == NULL) {
+        return false;
+    }
+    SDL_memset(block, 0, size);
+
+    layoutCharacters(c, block, capacity);
+    return true;
+}
+
+// Moves everything to a bigger block. Handles stay valid since they only
+// name slots, never addresses. The old block stays in the arena unused.
+bool reserveCharacters(SC_Characters *c, Uint32 capacity)
+{
+    if (capacity <= c->capacity) {
+        return true;
+    }
+
+    SC_Characters grown = *c;
+    size_t size = layoutCharacters(&grown, NULL, capacity);
+    void *block = arenaAlloc(c->arena, size);
+    if (block == NULL) {
+        return false;
+    }
+    SDL_memset(block, 0, size);
+    layoutCharacters(&grown, block, capacity);
+
+    SDL_memcpy(grown.posX, c->posX, c->count * sizeof(SC_Real));
+    SDL_memcpy(grown.posY, c->posY, c->count * sizeof(SC_Real));
+    SDL_memcpy(grown.velX, c->velX, c->count * sizeof(SC_Real));
+    SDL_memcpy(grown.velY, c->velY, c->count * sizeof(SC_Real));
+    SDL_memcpy(grown.accX, c->accX, c->count * sizeof(SC_Real));
+    SDL_memcpy(grown.accY, c->accY, c->count * sizeof(SC_Real));
+    SDL_memcpy(grown.prevX, c->prevX, c->count * sizeof(SC_Real));
+    SDL_memcpy(grown.prevY, c->prevY, c->count * sizeof(SC_Real));
+    SDL_memcpy(grown.floorY, c->floorY, c->count * sizeof(SC_Real));
+    SDL_memcpy(grown.state, c->state, c->count);
+    SDL_memcpy(grown.flags, c->flags, c->count);
+    SDL_memcpy(grown.denseSlot, c->denseSlot, c->count * sizeof(Uint32));
+    SDL_memcpy(grown.slotDense, c->slotDense, c->numSlots * sizeof(Uint32));
+    SDL_memcpy(grown.slotGen, c->slotGen, c->numSlots * sizeof(Uint32));
+    SDL_memcpy(grown.wakeIn, c->wakeIn, c->count * sizeof(Uint16));
+    SDL_memcpy(grown.schedule, c->schedule, c->count * sizeof(Uint32));
+    SDL_memcpy(grown.scheduledAt, c->scheduledAt, c->count * sizeof(Uint32));
+
+    *c = grown;
+    return true;
+}
+
+// Bumps the slot's generation so old handles go stale, then frees it
+static void retireSlot(SC_Characters *c, Uint32 slot)
+{
+    // Generation 0 is never handed out
+    if (++c->slotGen[slot] == 0) {
+        c->slotGen[slot] = 1;
+    }
+    c->slotDense[slot] = c->freeSlot;
+    c->freeSlot = slot;
+}
+
+// Despawns everything without freeing memory
+void clearCharacters(SC_Characters *c)
+{
+    c->count = 0;
+    c->numActive = 0;
+    c->numSorted = 0;
+    c->freeSlot = SC_SLOT_NONE;
+
+    // Walk backwards so the lowest slots get reused first
+    for (Uint32 slot = c->numSlots; slot-- > 0;) {
+        retireSlot(c, slot);
+    }
+}
+
+static void swapSchedule(SC_Characters *c, Uint32 a, Uint32 b)
+{
+    Uint32 ia = c->schedule[a];
+    Uint32 ib = c->schedule[b];
+    c->schedule[a] = ib;
+    c->schedule[b] = ia;
+    c->scheduledAt[ib] = a;
+    c->scheduledAt[ia] = b;
+}
+
+// Characters at rest are put to sleep and left out of ticks, see
+// rescheduleCharacters. Anything that changes a character from outside its
+// own tick has to wake it: input, a reset, loading a snapshot. Woken
+// characters go on the end of the active list.
+void wakeCharacter(SC_Characters *c, Uint32 i)
+{
+    Uint32 p = c->scheduledAt[i];
+    if (p >= c->numActive) {
+        swapSchedule(c, p, c->numActive++);
+    }
+}
+
+void sleepCharacter(SC_Characters *c, Uint32 i)
+{
+    Uint32 p = c->scheduledAt[i];
+    if (p < c->numActive) {
+        swapSchedule(c, p, --c->numActive);
+    }
+}
+
+void wakeAllCharacters(SC_Characters *c)
+{
+    for (Uint32 i = 0; i < c->count; i++) {
+        c->schedule[i] = i;
+        c->scheduledAt[i] = i;
+    }
+    c->numActive = c->count;
+    c->numSorted = c->count;
+}
+
+// Appends a zeroed character. Only allocates when the pool is full, and then
+// doubles it. Returns SC_HANDLE_NONE if that allocation fails.
+SC_Handle spawnCharacter(SC_Characters *c)
+{
+    if (c->count == c->capacity && !reserveCharacters(c, c->capacity > 0 ? c->capacity * 2 : 8)) {
+        return SC_HANDLE_NONE;
+    }
+
+    Uint32 slot = c->freeSlot;
+    if (slot != SC_SLOT_NONE) {
+        c->freeSlot = c->slotDense[slot];
+    } else {
+        slot = c->numSlots++;
+        c->slotGen[slot] = 1;
+    }
+
+    Uint32 i = c->count++;
+    c->slotDense[slot] = i;
+    c->denseSlot[i] = slot;
+
+    c->posX[i] = 0;
+    c->posY[i] = 0;
+    c->velX[i] = 0;
+    c->velY[i] = 0;
+    c->accX[i] = 0;
+    c->accY[i] = 0;
+    c->prevX[i] = 0;
+    c->prevY[i] = 0;
+    c->floorY[i] = 0;
+    c->state[i] = 0;
+    c->flags[i] = 0;
+    c->wakeIn[i] = 0;
+    c->schedule[i] = i;
+    c->scheduledAt[i] = i;
+    wakeCharacter(c, i);
+
+    return ((SC_Handle) c->slotGen[slot] << 32) | slot;
+}
+
+bool characterIndex(const SC_Characters *c, SC_Handle h, Uint32 *i)
+{
+    Uint32 slot = (Uint32) h;
+
+    if (slot >= c->numSlots || c->slotGen[slot] != (Uint32) (h >> 32)) {
+        return false;
+    }
+
+    *i = c->slotDense[slot];
+    return true;
+}
+
+SC_Handle characterHandle(const SC_Characters *c, Uint32 i)
+{
+    Uint32 slot = c->denseSlot[i];
+    return ((SC_Handle) c->slotGen[slot] << 32) | slot;
+}
+
+// Fills the hole with the last character so the live range stays dense
+bool despawnCharacter(SC_Characters *c, SC_Handle h)
+{
+    Uint32 i;
+    if (!characterIndex(c, h, &i)) {
+        return false;
+    }
+
+    Uint32 slot = c->denseSlot[i];
+    Uint32 last = --c->count;
+
+    // Off the schedule, then the last character takes over its place there.
+    // Both shuffle the active list, it gets sorted again on the next tick.
+    c->numSorted = 0;
+    sleepCharacter(c, i);
+    swapSchedule(c, c->scheduledAt[i], last);
+    if (i != last) {
+        c->scheduledAt[i] = c->scheduledAt[last];
+        c->schedule[c->scheduledAt[i]] = i;
+    }
+
+    if (i != last) {
+        c->posX[i] = c->posX[last];
+        c->posY[i] = c->posY[last];
+        c->velX[i] = c->velX[last];
+        c->velY[i] = c->velY[last];
+        c->accX[i] = c->accX[last];
+        c->accY[i] = c->accY[last];
+        c->prevX[i] = c->prevX[last];
+        c->prevY[i] = c->prevY[last];
+        c->floorY[i] = c->floorY[last];
+        c->state[i] = c->state[last];
+        c->flags[i] = c->flags[last];
+        c->wakeIn[i] = c->wakeIn[last];
+        c->denseSlot[i] = c->denseSlot[last];
+        c->slotDense[c->denseSlot[i]] = i;
+    }
+
+    retireSlot(c, slot);
+    return true;
+}
+
+// Called before a step so rendering can blend from where characters were
+void storePreviousPositions(SC_Characters *c)
+{
+    SDL_memcpy(c->prevX, c->posX, c->count * sizeof(SC_Real));
+    SDL_memcpy(c->prevY, c->posY, c->count * sizeof(SC_Real));
+}
+
+// Semi-implicit Euler: vel += delta * acc, clamped to +/- velMax, then
+// pos += delta * vel. Every kernel does the same operations in the same order
+// (no FMA) so they all produce identical results. `delta` is in whole ms, so
+// in fixed point it scales a value without any rounding.
+
+static void integrateScalar(SC_Characters *c, Uint32 begin, Uint32 end, Uint32 delta, SC_Real velMaxX, SC_Real velMaxY)
+{
+#ifdef SC_FIXED_POINT
+    const Sint32 d = (Sint32) delta;
+#else
+    const float d = (float) delta;
+#endif
+
+    for (Uint32 i = begin; i < end; i++) {
+        c->velX[i] = SDL_clamp(c->velX[i] + d * c->accX[i], -velMaxX, velMaxX);
+        c->velY[i] = SDL_clamp(c->velY[i] + d * c->accY[i], -velMaxY, velMaxY);
+        c->posX[i] += d * c->velX[i];
+        c->posY[i] += d * c->velY[i];
+    }
+}
+
+#ifdef SC_FIXED_POINT
+
+#ifdef SDL_SSE4_1_INTRINSICS
+static void SDL_TARGETING("sse4.1") integrateSSE41(SC_Characters *c, Uint32 begin, Uint32 end, Uint32 delta, SC_Real velMaxX, SC_Real velMaxY)
+{
+    const __m128i d = _mm_set1_epi32((Sint32) delta);
+    const __m128i maxX = _mm_set1_epi32(velMaxX);
+    const __m128i minX = _mm_set1_epi32(-velMaxX);
+    const __m128i maxY = _mm_set1_epi32(velMaxY);
+    const __m128i minY = _mm_set1_epi32(-velMaxY);
+
+    Uint32 i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m128i vx = _mm_add_epi32(_mm_loadu_si128((const __m128i *) (c->velX + i)), _mm_mullo_epi32(d, _mm_loadu_si128((const __m128i *) (c->accX + i))));
+        __m128i vy = _mm_add_epi32(_mm_loadu_si128((const __m128i *) (c->velY + i)), _mm_mullo_epi32(d, _mm_loadu_si128((const __m128i *) (c->accY + i))));
+        vx = _mm_min_epi32(_mm_max_epi32(vx, minX), maxX);
+        vy = _mm_min_epi32(_mm_max_epi32(vy, minY), maxY);
+        _mm_storeu_si128((__m128i *) (c->velX + i), vx);
+        _mm_storeu_si128((__m128i *) (c->velY + i), vy);
+        _mm_storeu_si128((__m128i *) (c->posX + i), _mm_add_epi32(_mm_loadu_si128((const __m128i *) (c->posX + i)), _mm_mullo_epi32(d, vx)));
+        _mm_storeu_si128((__m128i *) (c->posY + i), _mm_add_epi32(_mm_loadu_si128((const __m128i *) (c->posY + i)), _mm_mullo_epi32(d, vy)));
+    }
+
+    integrateScalar(c, i, end, delta, velMaxX, velMaxY);
+}
+#endif
+
+#ifdef SDL_AVX2_INTRINSICS
+static void SDL_TARGETING("avx2") integrateAVX2(SC_Characters *c, Uint32 begin, Uint32 end, Uint32 delta, SC_Real velMaxX, SC_Real velMaxY)
+{
+    const __m256i d = _mm256_set1_epi32((Sint32) delta);
+    const __m256i maxX = _mm256_set1_epi32(velMaxX);
+    const __m256i minX = _mm256_set1_epi32(-velMaxX);
+    const __m256i maxY = _mm256_set1_epi32(velMaxY);
+    const __m256i minY = _mm256_set1_epi32(-velMaxY);
+
+    Uint32 i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256i vx = _mm256_add_epi32(_mm256_loadu_si256((const __m256i *) (c->velX + i)), _mm256_mullo_epi32(d, _mm256_loadu_si256((const __m256i *) (c->accX + i))));
+        __m256i vy = _mm256_add_epi32(_mm256_loadu_si256((const __m256i *) (c->velY + i)), _mm256_mullo_epi32(d, _mm256_loadu_si256((const __m256i *) (c->accY + i))));
+        vx = _mm256_min_epi32(_mm256_max_epi32(vx, minX), maxX);
+        vy = _mm256_min_epi32(_mm256_max_epi32(vy, minY), maxY);
+        _mm256_storeu_si256((__m256i *) (c->velX + i), vx);
+        _mm256_storeu_si256((__m256i *) (c->velY + i), vy);
+        _mm256_storeu_si256((__m256i *) (c->posX + i), _mm256_add_epi32(_mm256_loadu_si256((const __m256i *) (c->posX + i)), _mm256_mullo_epi32(d, vx)));
+        _mm256_storeu_si256((__m256i *) (c->posY + i), _mm256_add_epi32(_mm256_loadu_si256((const __m256i *) (c->posY + i)), _mm256_mullo_epi32(d, vy)));
+    }
+
+    integrateScalar(c, i, end, delta, velMaxX, velMaxY);
+}
+#endif
+
+void selectIntegrateKernel()
+{
+    integrateCharacters = integrateScalar;
+
+#ifdef SDL_SSE4_1_INTRINSICS
+    if (SDL_HasSSE41()) {
+        integrateCharacters = integrateSSE41;
+    }
+#endif
+
+#ifdef SDL_AVX2_INTRINSICS
+    if (SDL_HasAVX2()) {
+        integrateCharacters = integrateAVX2;
+    }
+#endif
+}
+
+#else
+
+#ifdef SDL_SSE_INTRINSICS
+static void SDL_TARGETING("sse") integrateSSE(SC_Characters *c, Uint32 begin, Uint32 end, Uint32 delta, SC_Real velMaxX, SC_Real velMaxY)
+{
+    const __m128 d = _mm_set1_ps((float) delta);
+    const __m128 maxX = _mm_set1_ps(velMaxX);
+    const __m128 minX = _mm_set1_ps(-velMaxX);
+    const __m128 maxY = _mm_set1_ps(velMaxY);
+    const __m128 minY = _mm_set1_ps(-velMaxY);
+
+    Uint32 i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m128 vx = _mm_add_ps(_mm_loadu_ps(c->velX + i), _mm_mul_ps(d, _mm_loadu_ps(c->accX + i)));
+        __m128 vy = _mm_add_ps(_mm_loadu_ps(c->velY + i), _mm_mul_ps(d, _mm_loadu_ps(c->accY + i)));
+        vx = _mm_min_ps(_mm_max_ps(vx, minX), maxX);
+        vy = _mm_min_ps(_mm_max_ps(vy, minY), maxY);
+        _mm_storeu_ps(c->velX + i, vx);
+        _mm_storeu_ps(c->velY + i, vy);
+        _mm_storeu_ps(c->posX + i, _mm_add_ps(_mm_loadu_ps(c->posX + i), _mm_mul_ps(d, vx)));
+        _mm_storeu_ps(c->posY + i, _mm_add_ps(_mm_loadu_ps(c->posY + i), _mm_mul_ps(d, vy)));
+    }
+
+    integrateScalar(c, i, end, delta, velMaxX, velMaxY);
+}
+#endif
+
+#ifdef SDL_AVX_INTRINSICS
+static void SDL_TARGETING("avx") integrateAVX(SC_Characters *c, Uint32 begin, Uint32 end, Uint32 delta, SC_Real velMaxX, SC_Real velMaxY)
+{
+    const __m256 d = _mm256_set1_ps((float) delta);
+    const __m256 maxX = _mm256_set1_ps(velMaxX);
+    const __m256 minX = _mm256_set1_ps(-velMaxX);
+    const __m256 maxY = _mm256_set1_ps(velMaxY);
+    const __m256 minY = _mm256_set1_ps(-velMaxY);
+
+    Uint32 i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256 vx = _mm256_add_ps(_mm256_loadu_ps(c->velX + i), _mm256_mul_ps(d, _mm256_loadu_ps(c->accX + i)));
+        __m256 vy = _mm256_add_ps(_mm256_loadu_ps(c->velY + i), _mm256_mul_ps(d, _mm256_loadu_ps(c->accY + i)));
+        vx = _mm256_min_ps(_mm256_max_ps(vx, minX), maxX);
+        vy = _mm256_min_ps(_mm256_max_ps(vy, minY), maxY);
+        _mm256_storeu_ps(c->velX + i, vx);
+        _mm256_storeu_ps(c->velY + i, vy);
+        _mm256_storeu_ps(c->posX + i, _mm256_add_ps(_mm256_loadu_ps(c->posX + i), _mm256_mul_ps(d, vx)));
+        _mm256_storeu_ps(c->posY + i, _mm256_add_ps(_mm256_loadu_ps(c->posY + i), _mm256_mul_ps(d, vy)));
+    }
+
+    integrateScalar(c, i, end, delta, velMaxX, velMaxY);
+}
+#endif
+
+void selectIntegrateKernel()
+{
+    integrateCharacters = integrateScalar;
+
+#ifdef SDL_SSE_INTRINSICS
+    if (SDL_HasSSE()) {
+        integrateCharacters = integrateSSE;
+    }
+#endif
+
+#ifdef SDL_AVX_INTRINSICS
+    if (SDL_HasAVX()) {
+        integrateCharacters = integrateAVX;
+    }
+#endif
+}
+
+#endif
+
+Uint32 checksumCharacters(const SC_Characters *c)
+{
+    Uint32 crc = 0;
+    crc = SDL_crc32(crc, c->posX, c->count * sizeof(SC_Real));
+    crc = SDL_crc32(crc, c->posY, c->count * sizeof(SC_Real));
+    crc = SDL_crc32(crc, c->velX, c->count * sizeof(SC_Real));
+    crc = SDL_crc32(crc, c->velY, c->count * sizeof(SC_Real));
+    crc = SDL_crc32(crc, c->accX, c->count * sizeof(SC_Real));
+    crc = SDL_crc32(crc, c->accY, c->count * sizeof(SC_Real));
+    crc = SDL_crc32(crc, c->state, c->count);
+    crc = SDL_crc32(crc, c->flags, c->count);
+    return crc;
+}
@@ -0,0 +1,207 @@
+#include <SDL3/SDL.h>
+#include "types.h"
+
+// Every step refiles the characters that changed grid cell, then tests each
+// player against the characters in the 3x3 cells around it. Cells are bigger
+// than a character, so anything overlapping a player is in one of them.
+
+// Characters collide when their boxes overlap
+#define CONTACT_DISTANCE_X (2 * CHARACTER_HALF_WIDTH)
+#define CONTACT_DISTANCE_Y CHARACTER_HEIGHT
+
+// Follows the character pool when it grows. The grid is rebuilt on the next
+// step.
+bool reserveCollisions(SC_Collisions *g, Uint32 capacity)
+{
+    if (capacity <= g->capacity && g->order != NULL) {
+        return true;
+    }
+
+    Uint32 *order = arenaAlloc(g->arena, capacity * sizeof(Uint32));
+    Uint32 *where = arenaAlloc(g->arena, capacity * sizeof(Uint32));
+    Uint16 *filed = arenaAlloc(g->arena, capacity * sizeof(Uint16));
+    if (order == NULL || where == NULL || filed == NULL) {
+        return false;
+    }
+
+    g->order = order;
+    g->where = where;
+    g->filed = filed;
+    g->capacity = capacity;
+    g->count = SC_SLOT_NONE;
+    return true;
+}
+
+// The arrays come out of `arena`, like the character pool's
+bool initCollisions(SC_Collisions *g, SC_Arena *arena, Uint32 capacity)
+{
+    SDL_zerop(g);
+    g->arena = arena;
+    return reserveCollisions(g, capacity);
+}
+
+// Characters are filed by the middle of their box
+static Uint16 characterCell(const SC_Characters *c, Uint32 i)
+{
+    return (Uint16) (gridRow(c->posY[i] - CHARACTER_HEIGHT / 2) * SC_GRID_COLS + gridCol(c->posX[i]));
+}
+
+// Counting sort of every character index by cell
+static void fileCharacters(SC_Characters *c, SC_Collisions *g)
+{
+    Uint32 counts[SC_GRID_CELLS] = { 0 };
+
+    for (Uint32 i = 0; i < c->count; i++) {
+        g->filed[i] = characterCell(c, i);
+        counts[g->filed[i]]++;
+    }
+
+    Uint32 start = 0;
+    for (int k = 0; k < SC_GRID_CELLS; k++) {
+        g->cellStart[k] = start;
+        start += counts[k];
+    }
+    g->cellStart[SC_GRID_CELLS] = start;
+
+    Uint32 next[SC_GRID_CELLS];
+    SDL_memcpy(next, g->cellStart, sizeof(next));
+
+    for (Uint32 i = 0; i < c->count; i++) {
+        Uint32 k = next[g->filed[i]]++;
+        g->order[k] = i;
+        g->where[i] = k;
+    }
+
+    g->count = c->count;
+}
+
+static void swapCellOrder(SC_Collisions *g, Uint32 a, Uint32 b)
+{
+    Uint32 ia = g->order[a];
+    Uint32 ib = g->order[b];
+    g->order[a] = ib;
+    g->order[b] = ia;
+    g->where[ib] = a;
+    g->where[ia] = b;
+}
+
+// Same walk across the boundaries in between as moveBucket. Characters
+// rarely move more than one cell per step, so this is usually one swap.
+static void moveCell(SC_Collisions *g, Uint32 i, int from, int to)
+{
+    Uint32 p = g->where[i];
+
+    for (int k = from; k < to; k++) {
+        Uint32 last = g->cellStart[k + 1] - 1;
+        swapCellOrder(g, p, last);
+        p = last;
+        g->cellStart[k + 1]--;
+    }
+
+    for (int k = from; k > to; k--) {
+        Uint32 first = g->cellStart[k];
+        swapCellOrder(g, p, first);
+        p = first;
+        g->cellStart[k]++;
+    }
+}
+
+// Spawning and despawning move characters around in the pool, so the grid is
+// only patched up while the count stays the same
+void updateCollisionGrid(SC_Characters *c, SC_Collisions *g)
+{
+    if (g->count != c->count) {
+        fileCharacters(c, g);
+        return;
+    }
+
+    for (Uint32 i = 0; i < c->count; i++) {
+        Uint16 cell = characterCell(c, i);
+        if (g->filed[i] != cell) {
+            moveCell(g, i, g->filed[i], cell);
+            g->filed[i] = cell;
+        }
+    }
+}
+
+static int compareContacts(const void *a, const void *b)
+{
+    Uint32 x = ((const SC_Contact *) a)->other;
+    Uint32 y = ((const SC_Contact *) b)->other;
+    return (x > y) - (x < y);
+}
+
+// Adds the contacts of the character at index `player`
+static void collidePlayer(SC_Characters *c, SC_Collisions *g, Uint32 player)
+{
+    SC_Real x = c->posX[player];
+    SC_Real y = c->posY[player];
+    int cell = g->filed[player];
+    int row = cell / SC_GRID_COLS;
+    int col = cell % SC_GRID_COLS;
+
+    for (int r = SDL_max(row - 1, 0); r <= SDL_min(row + 1, SC_GRID_ROWS - 1); r++) {
+        for (int q = SDL_max(col - 1, 0); q <= SDL_min(col + 1, SC_GRID_COLS - 1); q++) {
+            int k = r * SC_GRID_COLS + q;
+            for (Uint32 n = g->cellStart[k]; n < g->cellStart[k + 1]; n++) {
+                Uint32 i = g->order[n];
+                SC_Real dx = c->posX[i] - x;
+                SC_Real dy = c->posY[i] - y;
+                if (dx <= -CONTACT_DISTANCE_X || dx >= CONTACT_DISTANCE_X
+                    || dy <= -CONTACT_DISTANCE_Y || dy >= CONTACT_DISTANCE_Y
+                    || i == player) {
+                    continue;
+                }
+
+                bool stomp = c->velY[player] > 0 && y <= c->posY[i] - CHARACTER_HEIGHT / 2;
+                g->contacts[g->numContacts++] = (SC_Contact) {
+                    .player = player,
+                    .other = i,
+                    .type = stomp ? SC_CONTACT_STOMP : SC_CONTACT_BUMP,
+                };
+            }
+        }
+    }
+}
+
+// Finds every character overlapping a player. A contact is a stomp when the
+// player is falling and its feet are in the top half of the other
+// character, anything else is a bump. Contacts are only collected, nothing
+// reacts to them yet.
+void collideCharacters(SC_AppState *s)
+{
+    SC_Characters *c = &s->characters;
+    SC_Collisions *g = &s->collisions;
+
+    g->numContacts = 0;
+
+    // Each player can touch every other character
+    g->contacts = arenaAlloc(&s->frame, SC_MAX_PLAYERS * c->count * sizeof(SC_Contact));
+    if (!reserveCollisions(g, c->capacity) || g->contacts == NULL) {
+        return;
+    }
+
+    updateCollisionGrid(c, g);
+
+    for (Uint32 p = 0; p < s->numPlayers; p++) {
+        Uint32 player;
+        if (!characterIndex(c, s->players[p], &player)) {
+            continue;
+        }
+
+        // The order within a cell depends on how characters were moved
+        // between cells, sorting keeps contacts the same for a replay
+        // started mid-way
+        Uint32 first = g->numContacts;
+        collidePlayer(c, g, player);
+        SDL_qsort(g->contacts + first, g->numContacts - first, sizeof(SC_Contact), compareContacts);
+    }
+
+    for (Uint32 n = 0; n < g->numContacts; n++) {
+        if (g->contacts[n].type == SC_CONTACT_STOMP) {
+            g->totalStomps++;
+        } else {
+            g->totalBumps++;
+        }
+    }
+}
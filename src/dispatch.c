@@ -0,0 +1,163 @@
+#include <SDL3/SDL.h>
+#include "types.h"
+#include "fsm.h"
+
+#define SC_DISPATCH_REGROUP_TICKS 32
+
+// Follows the character pool when it grows. The grouping is rebuilt on the
+// next tick.
+bool reserveDispatch(SC_Dispatch *d, Uint32 capacity)
+{
+    if (capacity <= d->capacity && d->order != NULL) {
+        return true;
+    }
+
+    Uint32 *order = arenaAlloc(d->arena, capacity * sizeof(Uint32));
+    Uint32 *where = arenaAlloc(d->arena, capacity * sizeof(Uint32));
+    Uint8 *filed = arenaAlloc(d->arena, capacity * sizeof(Uint8));
+    if (order == NULL || where == NULL || filed == NULL) {
+        return false;
+    }
+
+    d->order = order;
+    d->where = where;
+    d->filed = filed;
+    d->capacity = capacity;
+    d->count = SC_SLOT_NONE;
+    return true;
+}
+
+// The arrays come out of `arena`, like the character pool's
+bool initDispatch(SC_Dispatch *d, SC_Arena *arena, Uint32 capacity)
+{
+    SDL_zerop(d);
+    d->arena = arena;
+    return reserveDispatch(d, capacity);
+}
+
+// One FSM tick per character in [begin, end), in storage order
+void tickCharactersDirect(SC_Characters *c, Uint32 begin, Uint32 end, Uint64 delta, Uint64 now)
+{
+    for (Uint32 i = begin; i < end; i++) {
+        Uint64 opts = 0;
+
+        int newState = characterTick(c, i, &opts);
+
+        if (newState != SC_FSM_NO_CHANGE) {
+            //SDL_Log("Leave %d, Enter %d", c->state[i], newState);
+            characterTransition(c, i, newState, &opts);
+        }
+    }
+}
+
+// Counting sort of every character index by state
+void groupCharactersByState(SC_Characters *c, SC_Dispatch *d)
+{
+    Uint32 counts[SC_CHARACTER_MOVE_STATE_TOTAL] = { 0 };
+
+    for (Uint32 i = 0; i < c->count; i++) {
+        counts[c->state[i]]++;
+    }
+
+    Uint32 start = 0;
+    for (int s = 0; s < SC_CHARACTER_MOVE_STATE_TOTAL; s++) {
+        d->bucketStart[s] = start;
+        start += counts[s];
+    }
+    d->bucketStart[SC_CHARACTER_MOVE_STATE_TOTAL] = start;
+
+    Uint32 next[SC_CHARACTER_MOVE_STATE_TOTAL];
+    SDL_memcpy(next, d->bucketStart, sizeof(next));
+
+    for (Uint32 i = 0; i < c->count; i++) {
+        Uint32 k = next[c->state[i]]++;
+        d->order[k] = i;
+        d->where[i] = k;
+        d->filed[i] = c->state[i];
+    }
+
+    d->count = c->count;
+    d->ticksSinceGroup = 0;
+}
+
+static void swapOrder(SC_Dispatch *d, Uint32 a, Uint32 b)
+{
+    Uint32 ia = d->order[a];
+    Uint32 ib = d->order[b];
+    d->order[a] = ib;
+    d->order[b] = ia;
+    d->where[ib] = a;
+    d->where[ia] = b;
+}
+
+// Moves character i from bucket `from` to bucket `to` by walking it across
+// the bucket boundaries in between, one swap per boundary
+static void moveBucket(SC_Dispatch *d, Uint32 i, int from, int to)
+{
+    Uint32 p = d->where[i];
+
+    for (int s = from; s < to; s++) {
+        Uint32 last = d->bucketStart[s + 1] - 1;
+        swapOrder(d, p, last);
+        p = last;
+        d->bucketStart[s + 1]--;
+    }
+
+    for (int s = from; s > to; s--) {
+        Uint32 first = d->bucketStart[s];
+        swapOrder(d, p, first);
+        p = first;
+        d->bucketStart[s]++;
+    }
+}
+
+// Refiles every character whose state changed since the last tick, whether
+// from a transition or from eventCharacter. Each move scrambles the order
+// within a bucket a little, so every SC_DISPATCH_REGROUP_TICKS the whole
+// grouping is rebuilt to get back to walking memory forwards.
+void regroupCharacters(SC_Characters *c, SC_Dispatch *d)
+{
+    if (d->count != c->count || ++d->ticksSinceGroup >= SC_DISPATCH_REGROUP_TICKS) {
+        groupCharactersByState(c, d);
+        return;
+    }
+
+    for (Uint32 i = 0; i < c->count; i++) {
+        if (d->filed[i] != c->state[i]) {
+            moveBucket(d, i, d->filed[i], c->state[i]);
+            d->filed[i] = c->state[i];
+        }
+    }
+}
+
+// Runs each state's tick loop once over that state's whole bucket.
+// Transitions are only collected during the pass and applied afterwards,
+// which leaves the buckets intact while they are being walked. Each tick only
+// touches its own character, so the result is the same as the direct
+// per-character loop. The transitions only last the tick, so they go in
+// `scratch`.
+void tickCharactersBatched(SC_Characters *c, SC_Dispatch *d, SC_Arena *scratch, Uint64 delta, Uint64 now)
+{
+    SC_Transition *transitions = arenaAlloc(scratch, c->count * sizeof(SC_Transition));
+    if (!reserveDispatch(d, c->capacity) || transitions == NULL) {
+        tickCharactersDirect(c, 0, c->count, delta, now);
+        return;
+    }
+
+    regroupCharacters(c, d);
+    d->numTransitions = 0;
+
+    for (int s = 0; s < SC_CHARACTER_MOVE_STATE_TOTAL; s++) {
+        Uint32 start = d->bucketStart[s];
+        Uint32 n = d->bucketStart[s + 1] - start;
+
+        if (n > 0) {
+            d->numTransitions += tickCharacterBatch(c, s, d->order + start, n, transitions + d->numTransitions);
+        }
+    }
+
+    for (Uint32 k = 0; k < d->numTransitions; k++) {
+        SC_Transition *t = transitions + k;
+        characterTransition(c, t->i, t->state, &t->opts);
+    }
+}
@@ -0,0 +1,309 @@
+#include <SDL3/SDL.h>
+#include "types.h"
+#include "fsm.h"
+
+// The enemy pool is sized up front, so spawning and despawning never
+// allocate while the game runs. The level's schedule and arena mode decide
+// when pipes let enemies out.
+
+#define ENEMY_DEFAULT_CAPACITY 256
+
+// Most enemies arena mode lets out per tick, spread over the pipes in turn
+#define ENEMY_ARENA_SPAWNS_PER_TICK 64
+
+// Enemies of a kind walk at 8/8 to 15/8 of its speed, so a crowd let out of
+// one pipe spreads out instead of walking in lockstep
+#define ENEMY_SPEED_SPREAD 8
+
+// Fewest enemies worth handing to another thread. They tick in about half
+// the time characters do.
+#define ENEMY_TICK_GRAIN 2048
+
+// A player touching an enemy it just flipped doesn't kick it straight away
+#define ENEMY_KICK_GRACE 20
+
+static size_t enemiesArraySize(Uint32 capacity, size_t elSize)
+{
+    size_t size = capacity * elSize;
+    return (size + SC_CHARACTERS_ALIGN - 1) & ~((size_t) SC_CHARACTERS_ALIGN - 1);
+}
+
+// Same as layoutCharacters
+static size_t layoutEnemies(SC_Enemies *e, void *block, Uint32 capacity)
+{
+    size_t reals = enemiesArraySize(capacity, sizeof(SC_Real));
+    size_t halves = enemiesArraySize(capacity, sizeof(Uint16));
+    size_t bytes = enemiesArraySize(capacity, sizeof(Uint8));
+
+    if (block != NULL) {
+        Uint8 *p = block;
+        e->posX = (SC_Real *) p; p += reals;
+        e->posY = (SC_Real *) p; p += reals;
+        e->velX = (SC_Real *) p; p += reals;
+        e->velY = (SC_Real *) p; p += reals;
+        e->floorY = (SC_Real *) p; p += reals;
+        e->speed = (SC_Real *) p; p += reals;
+        e->timer = (Uint16 *) p; p += halves;
+        e->state = p; p += bytes;
+        e->kind = p; p += bytes;
+        e->flags = p;
+        e->capacity = capacity;
+    }
+
+    return 6 * reals + halves + 3 * bytes;
+}
+
+// Like characters, the arrays belong to `arena`
+bool initEnemies(SC_Enemies *e, SC_Arena *arena, Uint32 capacity)
+{
+    SDL_zerop(e);
+    e->arena = arena;
+
+    size_t size = layoutEnemies(e, NULL, capacity);
+    void *block = arenaAlloc(arena, size);
+    if (block == NULL) {
+        return false;
+    }
+    SDL_memset(block, 0, size);
+
+    layoutEnemies(e, block, capacity);
+    return true;
+}
+
+// Only for setting up, see setArenaEnemies and loadSnapshot
+bool reserveEnemies(SC_Enemies *e, Uint32 capacity)
+{
+    if (capacity <= e->capacity) {
+        return true;
+    }
+
+    SC_Enemies grown = *e;
+    size_t size = layoutEnemies(&grown, NULL, capacity);
+    void *block = arenaAlloc(e->arena, size);
+    if (block == NULL) {
+        return false;
+    }
+    SDL_memset(block, 0, size);
+    layoutEnemies(&grown, block, capacity);
+
+    SDL_memcpy(grown.posX, e->posX, e->count * sizeof(SC_Real));
+    SDL_memcpy(grown.posY, e->posY, e->count * sizeof(SC_Real));
+    SDL_memcpy(grown.velX, e->velX, e->count * sizeof(SC_Real));
+    SDL_memcpy(grown.velY, e->velY, e->count * sizeof(SC_Real));
+    SDL_memcpy(grown.floorY, e->floorY, e->count * sizeof(SC_Real));
+    SDL_memcpy(grown.speed, e->speed, e->count * sizeof(SC_Real));
+    SDL_memcpy(grown.timer, e->timer, e->count * sizeof(Uint16));
+    SDL_memcpy(grown.state, e->state, e->count);
+    SDL_memcpy(grown.kind, e->kind, e->count);
+    SDL_memcpy(grown.flags, e->flags, e->count);
+
+    *e = grown;
+    return true;
+}
+
+// Despawns everything and starts the level's schedule over
+void clearEnemies(SC_Enemies *e)
+{
+    e->count = 0;
+    e->nextScheduled = 0;
+    e->numSpawned = 0;
+    e->dropped = 0;
+    e->totalFlipped = 0;
+    e->totalKilled = 0;
+}
+
+// Lets an enemy of `kind` out of `pipe`. Returns false with the pool full.
+static bool spawnEnemy(SC_Enemies *e, const SC_Pipe *pipe, Uint32 kind)
+{
+    if (e->count == e->capacity) {
+        e->dropped++;
+        return false;
+    }
+
+    Uint32 i = e->count++;
+    kind %= ENEMY_KIND_TOTAL;
+    SC_Real speed = enemyKindSpeed[kind] * (Sint32) (ENEMY_SPEED_SPREAD + e->numSpawned % ENEMY_SPEED_SPREAD) / ENEMY_SPEED_SPREAD;
+    e->numSpawned++;
+
+    e->posX[i] = REAL_FROM_INT(pipe->x);
+    e->posY[i] = REAL_FROM_INT(pipe->y);
+    e->velX[i] = pipe->dir > 0 ? speed : -speed;
+    e->velY[i] = 0;
+    e->floorY[i] = e->posY[i];
+    e->speed[i] = speed;
+    e->timer[i] = 0;
+    e->state[i] = SC_ENEMY_WALK;
+    e->kind[i] = (Uint8) kind;
+    e->flags[i] = pipe->dir > 0 ? CHARACTER_FLAG_FACE_RIGHT : CHARACTER_FLAG_FACE_LEFT;
+    return true;
+}
+
+// Lets out everything the level has scheduled up to this tick, then in arena
+// mode tops the enemies back up to numArenaEnemies
+void spawnEnemies(SC_AppState *s)
+{
+    SC_Enemies *e = &s->enemies;
+    const SC_Level *l = s->level;
+
+    while (e->nextScheduled < l->numScheduled && l->schedule[e->nextScheduled].tick <= s->tickCount) {
+        const SC_PipeSpawn *spawn = &l->schedule[e->nextScheduled++];
+        spawnEnemy(e, &l->pipes[spawn->pipe], spawn->kind);
+    }
+
+    if (l->numPipes == 0) {
+        return;
+    }
+    for (Uint32 n = 0; n < ENEMY_ARENA_SPAWNS_PER_TICK && e->count < s->numArenaEnemies; n++) {
+        spawnEnemy(e, &l->pipes[e->numSpawned % l->numPipes], e->numSpawned);
+    }
+}
+
+// Arena mode keeps `n` enemies out at all times, on top of the level's own.
+// The pool grows to fit here, not while spawning.
+bool setArenaEnemies(SC_AppState *s, Uint32 n)
+{
+    if (!reserveEnemies(&s->enemies, n + s->level->numScheduled)) {
+        return false;
+    }
+    s->numArenaEnemies = n;
+    return true;
+}
+
+// Gravity, movement, wrapping around the sides of the playfield, and landing
+// on the floor for everything but dying enemies, which fall out of the
+// level. Written as one branch-free pass so the compiler can vectorize it.
+static void integrateEnemies(SC_Enemies *e, Uint32 begin, Uint32 end, Uint32 delta)
+{
+#ifdef SC_FIXED_POINT
+    const Sint32 d = (Sint32) delta;
+#else
+    const float d = (float) delta;
+#endif
+    const SC_Real width = REAL_FROM_INT(SC_PLAYFIELD_WIDTH);
+
+    for (Uint32 i = begin; i < end; i++) {
+        SC_Real velY = SDL_min(e->velY[i] + d * ENEMY_Y_ACC, ENEMY_Y_VEL_MAX);
+        SC_Real x = e->posX[i] + d * e->velX[i];
+        SC_Real y = e->posY[i] + d * velY;
+
+        x = x < 0 ? x + width : x;
+        x = x >= width ? x - width : x;
+
+        bool landed = y >= e->floorY[i] && e->state[i] != SC_ENEMY_DIE;
+        e->posX[i] = x;
+        e->posY[i] = landed ? e->floorY[i] : y;
+        e->velY[i] = landed ? 0 : velY;
+    }
+}
+
+void eventEnemy(SC_Enemies *e, Uint32 i, SC_Event ev, Uint64 opts)
+{
+    int newState = enemyInput(e, i, ev, &opts);
+
+    if (newState != SC_FSM_NO_CHANGE) {
+        enemyTransition(e, i, newState, &opts);
+    }
+}
+
+typedef struct SC_EnemyJob {
+    SC_Enemies *e;
+    const SC_Level *level;
+    Uint64 delta;
+} SC_EnemyJob;
+
+// Every enemy only touches its own slots, like tickCharactersJob
+static void tickEnemiesJob(void *data, Uint32 begin, Uint32 end)
+{
+    SC_EnemyJob *job = data;
+    SC_Enemies *e = job->e;
+
+    findFloors(job->level, e->posX, e->posY, ENEMY_HALF_WIDTH, e->floorY, begin, end);
+    integrateEnemies(e, begin, end, (Uint32) job->delta);
+
+    for (Uint32 i = begin; i < end; i++) {
+        Uint64 opts = 0;
+        int newState = enemyTick(e, i, &opts);
+        if (newState != SC_FSM_NO_CHANGE) {
+            enemyTransition(e, i, newState, &opts);
+        }
+    }
+}
+
+// Drops the enemies that are gone, keeping the rest in order
+static void compactEnemies(SC_Enemies *e)
+{
+    Uint32 n = 0;
+
+    for (Uint32 i = 0; i < e->count; i++) {
+        if (e->state[i] == SC_ENEMY_GONE) {
+            continue;
+        }
+        if (n != i) {
+            e->posX[n] = e->posX[i];
+            e->posY[n] = e->posY[i];
+            e->velX[n] = e->velX[i];
+            e->velY[n] = e->velY[i];
+            e->floorY[n] = e->floorY[i];
+            e->speed[n] = e->speed[i];
+            e->timer[n] = e->timer[i];
+            e->state[n] = e->state[i];
+            e->kind[n] = e->kind[i];
+            e->flags[n] = e->flags[i];
+        }
+        n++;
+    }
+
+    e->count = n;
+}
+
+// Enemy ticks are a short switch, so both dispatch modes run them in
+// storage order, split across the workers
+void tickEnemies(SC_AppState *s, Uint64 delta)
+{
+    SC_EnemyJob job = {
+        .e = &s->enemies,
+        .level = s->level,
+        .delta = delta,
+    };
+    runWorkers(s->workers, tickEnemiesJob, &job, s->enemies.count, ENEMY_TICK_GRAIN);
+    compactEnemies(&s->enemies);
+}
+
+// Players against every enemy. There are never more than SC_MAX_PLAYERS
+// players, so a straight pass over the enemy arrays costs less than keeping
+// a grid for them. Coming down on a walking enemy flips it, touching a
+// flipped one kicks it out of the level.
+void collideEnemies(SC_AppState *s)
+{
+    SC_Characters *c = &s->characters;
+    SC_Enemies *e = &s->enemies;
+
+    for (Uint32 p = 0; p < s->numPlayers; p++) {
+        Uint32 player;
+        if (!characterIndex(c, s->players[p], &player)) {
+            continue;
+        }
+
+        SC_Real x = c->posX[player];
+        SC_Real y = c->posY[player];
+        bool falling = c->velY[player] > 0;
+
+        for (Uint32 i = 0; i < e->count; i++) {
+            SC_Real dx = e->posX[i] - x;
+            SC_Real dy = e->posY[i] - y;
+            if (dx <= -(CHARACTER_HALF_WIDTH + ENEMY_HALF_WIDTH) || dx >= CHARACTER_HALF_WIDTH + ENEMY_HALF_WIDTH
+                || dy <= -CHARACTER_HEIGHT || dy >= ENEMY_HEIGHT) {
+                continue;
+            }
+
+            Uint8 state = e->state[i];
+            if ((state == SC_ENEMY_WALK || state == SC_ENEMY_FALL) && falling && y <= e->posY[i] - ENEMY_HEIGHT / 2) {
+                eventEnemy(e, i, SC_EVENT_STOMP, 0);
+                e->totalFlipped++;
+            } else if ((state == SC_ENEMY_FLIP && e->timer[i] <= ENEMY_FLIP_TICKS - ENEMY_KICK_GRACE) || state == SC_ENEMY_RECOVER) {
+                eventEnemy(e, i, SC_EVENT_KICK, dx > 0 ? ENEMY_KICK_RIGHT : 0);
+                e->totalKilled++;
+            }
+        }
+    }
+}
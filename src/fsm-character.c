@@ -5,758 +5,457 @@
 extern SC_FSM *FSMsCharacter;
 SC_FSM *FSMsCharacter;
 
-#define PLAYER_X_VEL_START 0.05f
-#define PLAYER_X_VEL_MAX   0.25f
-#define PLAYER_X_ACC_RUN   0.00075f
-#define PLAYER_X_ACC_STOP  0.00050f
+// Units are px and ms. In fixed point the constants are rounded to 1/65536,
+// which puts PLAYER_X_ACC_STOP 0.7% off. Positions stay within about a pixel
+// of the float build over a whole jump arc, and landings and state changes
+// happen on the same ticks.
+#define PLAYER_X_VEL_START REAL(0.05)
+#define PLAYER_X_VEL_MAX   REAL(0.25)
+#define PLAYER_X_ACC_RUN   REAL(0.00075)
+#define PLAYER_X_ACC_STOP  REAL(0.00050)
 
 // Max height = 150
 // Time to peak = 375
 // Time to ground = 750
-#define PLAYER_Y_VEL_MAX    0.8025f
+// Those are for smooth motion. Stepped every FIXED_TICK_RATE it comes out
+// at 144 px, 384 ms and 736 ms, see --sweep tuning/default.txt.
+#define PLAYER_Y_VEL_MAX    REAL(0.8025)
 #define PLAYER_Y_VEL_START -PLAYER_Y_VEL_MAX
-#define PLAYER_Y_ACC        0.00214f
+#define PLAYER_Y_ACC        REAL(0.00214)
 // This should allow a bunny hop of 1 height
-#define PLAYER_Y_VEL_STOP  -0.214f
-
-#define GROUND_Y 600.f
-
-#define PLAYER_JUMP_HEIGHT_MAX 120.0f
+#define PLAYER_Y_VEL_STOP   REAL(-0.214)
+
+// Characters are CHARACTER_HALF_WIDTH either side of posX, standing on posY
+#define CHARACTER_HALF_WIDTH REAL(20)
+#define CHARACTER_HEIGHT     REAL(40)
+
+#define PLAYER_JUMP_HEIGHT_MAX REAL(120)
+
+// What every pool starts with. --sweep runs pools with other values.
+const SC_CharacterTuning characterTuningDefault = {
+    .xVelStart = PLAYER_X_VEL_START,
+    .xVelMax = PLAYER_X_VEL_MAX,
+    .xAccRun = PLAYER_X_ACC_RUN,
+    .xAccStop = PLAYER_X_ACC_STOP,
+    .yVelStart = PLAYER_Y_VEL_START,
+    .yVelMax = PLAYER_Y_VEL_MAX,
+    .yAcc = PLAYER_Y_ACC,
+    .yVelStop = PLAYER_Y_VEL_STOP,
+};
 
 #define CHARACTER_MOVE_RIGHT 0b01
 #define CHARACTER_MOVE_LEFT  0b10
 
-void CharacterEnterStand(void *el, Uint64 *opts)
-{
-    SC_Character *c = el;
-    c->vel.x = 0;
-    c->vel.y = 0;
-    c->acc.x = 0;
-    c->acc.y = 0;
-}
+// The character FSM is generated from the tables below. Every state is a
+// horizontal mode (standing, starting to run, running, stopping) paired with
+// a vertical one (on the ground, jumping, falling), and entering a state sets
+// up both halves. Inputs and ticks are lists of rows per state: the first
+// row whose event or condition matches applies its action to the opts and
+// moves to its target state. No state does anything on exit.
+//
+// From the tables come a switch-based dispatcher (characterInput,
+// characterTick, characterTransition) that the compiler can inline, and the
+// SC_FSM function-pointer table in FSMsCharacter.
+
+// id, Name, horizontal, vertical
+#define CHARACTER_STATES(X) \
+    X(STAND,          Stand,         Stop,  Ground) \
+    X(RUN_START,      RunStart,      Start, Ground) \
+    X(RUN,            Run,           Run,   Ground) \
+    X(RUN_STOP,       RunStop,       Brake, Ground) \
+    X(STAND_JUMP,     StandJump,     Stop,  Jump) \
+    X(STAND_FALL,     StandFall,     Stop,  Fall) \
+    X(RUN_START_JUMP, RunStartJump,  Start, Jump) \
+    X(RUN_START_FALL, RunStartFall,  Start, Fall) \
+    X(RUN_JUMP,       RunJump,       Coast, Jump) \
+    X(RUN_FALL,       RunFall,       Coast, Fall) \
+    X(RUN_STOP_JUMP,  RunStopJump,   Brake, Jump) \
+    X(RUN_STOP_FALL,  RunStopFall,   Brake, Fall)
+
+// Inputs: event, action, target
+//
+// Pressing the other direction while running stops (Keep). Releasing one of
+// two held directions while stopped or stopping runs the other way (Flip).
+#define CHARACTER_INPUTS_STAND(X) \
+    X(RUN_START, None, RUN_START) \
+    X(RUN_STOP,  Flip, RUN_START) \
+    X(JUMP,      None, STAND_JUMP)
+
+#define CHARACTER_INPUTS_RUN_START(X) \
+    X(RUN_STOP,  None, RUN_STOP) \
+    X(RUN_START, Keep, RUN_STOP) \
+    X(JUMP,      Acc,  RUN_START_JUMP)
+
+#define CHARACTER_INPUTS_RUN(X) \
+    X(RUN_STOP,  None, RUN_STOP) \
+    X(RUN_START, Keep, RUN_STOP) \
+    X(JUMP,      None, RUN_JUMP)
+
+#define CHARACTER_INPUTS_RUN_STOP(X) \
+    X(RUN_START, None, RUN_START) \
+    X(RUN_STOP,  Flip, RUN_START) \
+    X(JUMP,      Vel,  RUN_STOP_JUMP)
+
+#define CHARACTER_INPUTS_STAND_JUMP(X) \
+    X(RUN_START, None, RUN_START_JUMP) \
+    X(RUN_STOP,  Flip, RUN_START_JUMP) \
+    X(JUMP_STOP, Cut,  STAND_FALL)
+
+#define CHARACTER_INPUTS_STAND_FALL(X) \
+    X(RUN_START, None, RUN_START_FALL) \
+    X(RUN_STOP,  Flip, RUN_START_FALL)
 
-void CharacterExitStand(void *el, Uint64 *opts)
-{
-}
+#define CHARACTER_INPUTS_RUN_START_JUMP(X) \
+    X(RUN_STOP,  None,   RUN_STOP_JUMP) \
+    X(RUN_START, Keep,   RUN_STOP_JUMP) \
+    X(JUMP_STOP, CutAcc, RUN_START_FALL)
 
-int CharacterInputStand(void *el, SC_Event e, Uint64 now, Uint64 *opts)
-{
-    if (e == SC_EVENT_RUN_START) {
-        return SC_CHARACTER_RUN_START;
-    } else if (e == SC_EVENT_RUN_STOP) {
-        // If both left and right were down, update *opts with
-        // correct direction to move
-        Uint64 optUpdate =  (*opts & CHARACTER_MOVE_RIGHT) > 0 ? CHARACTER_MOVE_LEFT : CHARACTER_MOVE_RIGHT;
-        *opts &= ~*opts;
-        *opts |= optUpdate;
-        return SC_CHARACTER_RUN_START;
-    } else if (e == SC_EVENT_JUMP) {
-        return SC_CHARACTER_STAND_JUMP;
-    }
+#define CHARACTER_INPUTS_RUN_START_FALL(X) \
+    X(RUN_STOP,  None, RUN_STOP_FALL) \
+    X(RUN_START, Keep, RUN_STOP_FALL)
 
-    return SC_FSM_NO_CHANGE;
-}
+#define CHARACTER_INPUTS_RUN_JUMP(X) \
+    X(RUN_STOP,  None, RUN_STOP_JUMP) \
+    X(RUN_START, Keep, RUN_STOP_JUMP) \
+    X(JUMP_STOP, Cut,  RUN_FALL)
 
-int CharacterTickStand(void *el, Uint64 delta, Uint64 now, Uint64 *opts)
-{
-    return SC_FSM_NO_CHANGE;
-}
+#define CHARACTER_INPUTS_RUN_FALL(X) \
+    X(RUN_STOP,  None, RUN_STOP_FALL) \
+    X(RUN_START, Keep, RUN_STOP_FALL)
 
-void CharacterEnterRun(void *el, Uint64 *opts)
-{
-    SC_Character *c = el;
-    float dir = (*opts & CHARACTER_MOVE_RIGHT) > 0 ? 1.0f : -1.0f;
-    c->vel.x = dir * PLAYER_X_VEL_MAX;
-    c->vel.y = 0;
-    c->acc.x = 0;
-    c->acc.y = 0;
-}
+#define CHARACTER_INPUTS_RUN_STOP_JUMP(X) \
+    X(RUN_START, None,     RUN_START_JUMP) \
+    X(RUN_STOP,  Flip,     RUN_START_JUMP) \
+    X(JUMP_STOP, CutBrake, RUN_STOP_FALL)
 
-void CharacterExitRun(void *el, Uint64 *opts)
-{
-}
+#define CHARACTER_INPUTS_RUN_STOP_FALL(X) \
+    X(RUN_START, None, RUN_START_FALL) \
+    X(RUN_STOP,  Flip, RUN_START_FALL)
 
-int CharacterInputRun(void *el, SC_Event e, Uint64 now, Uint64 *opts)
-{
-    SC_Character *c = el;
-    if (e == SC_EVENT_RUN_STOP) {
-        return SC_CHARACTER_RUN_STOP;
-    } else if (e == SC_EVENT_RUN_START) {
-        *opts &= ~(c->vel.x > 0 ? CHARACTER_MOVE_LEFT : CHARACTER_MOVE_RIGHT);
-        *opts |= c->vel.x > 0 ? CHARACTER_MOVE_RIGHT : CHARACTER_MOVE_LEFT;
-        return SC_CHARACTER_RUN_STOP;
-    } else if (e == SC_EVENT_JUMP) {
-        return SC_CHARACTER_RUN_JUMP;
-    }
-    return SC_FSM_NO_CHANGE;
-}
+// Ticks, checked in order: condition, action, target
+#define CHARACTER_TICKS_STAND(X) \
+    X(OffFloor, None, STAND_FALL)
 
-int CharacterTickRun(void *el, Uint64 delta, Uint64 now, Uint64 *opts)
-{
-    SC_Character *c = el;
-    c->pos.x += delta * c->vel.x;
-    return SC_FSM_NO_CHANGE;
-}
+#define CHARACTER_TICKS_RUN_START(X) \
+    X(OffFloor, Acc, RUN_START_FALL) \
+    X(AtMax,    Vel, RUN)
 
-void CharacterEnterRunStart(void *el, Uint64 *opts)
-{
-    SC_Character *c = el;
-    float dir = (*opts & CHARACTER_MOVE_RIGHT) > 0 ? 1.0f : -1.0f;
-    if (c->vel.x == 0) {
-        c->vel.x = dir * PLAYER_X_VEL_START;
-    }
-    c->flags = dir > 0 ? CHARACTER_FLAG_FACE_RIGHT : CHARACTER_FLAG_FACE_LEFT;
-    c->acc.x = dir * PLAYER_X_ACC_RUN;
-    c->vel.y = 0;
-    c->acc.y = 0;
-}
+#define CHARACTER_TICKS_RUN(X) \
+    X(OffFloor, None, RUN_FALL)
 
-void CharacterExitRunStart(void *el, Uint64 *opts)
-{
-}
+#define CHARACTER_TICKS_RUN_STOP(X) \
+    X(OffFloor, Vel,  RUN_STOP_FALL) \
+    X(Stopped,  None, STAND)
 
-int CharacterInputRunStart(void *el, SC_Event e, Uint64 now, Uint64 *opts)
-{
-    SC_Character *c = el;
-
-    if (e == SC_EVENT_RUN_STOP) {
-        return SC_CHARACTER_RUN_STOP;
-    } else if (e == SC_EVENT_RUN_START) {
-        // If both left and right were down, update *opts with
-        // correct move direction
-        *opts &= ~(c->vel.x > 0 ? CHARACTER_MOVE_LEFT : CHARACTER_MOVE_RIGHT);
-        *opts |= c->vel.x > 0 ? CHARACTER_MOVE_RIGHT : CHARACTER_MOVE_LEFT;
-        return SC_CHARACTER_RUN_STOP;
-    } else if (e == SC_EVENT_JUMP) {
-        *opts |= c->acc.x > 0 ? CHARACTER_MOVE_RIGHT : CHARACTER_MOVE_LEFT;
-        return SC_CHARACTER_RUN_START_JUMP;
-    }
+#define CHARACTER_TICKS_STAND_JUMP(X) \
+    X(Peak, None, STAND_FALL)
 
-    return SC_FSM_NO_CHANGE;
-}
+#define CHARACTER_TICKS_STAND_FALL(X) \
+    X(Landed, None, STAND)
 
-int CharacterTickRunStart(void *el, Uint64 delta, Uint64 now, Uint64 *opts)
-{
-    Uint64 ret = SC_FSM_NO_CHANGE;
+#define CHARACTER_TICKS_RUN_START_JUMP(X) \
+    X(AtMax, Vel, RUN_JUMP) \
+    X(Peak,  Acc, RUN_START_FALL)
 
-    SC_Character *c = el;
+#define CHARACTER_TICKS_RUN_START_FALL(X) \
+    X(AtMax,  Vel, RUN_FALL) \
+    X(Landed, Acc, RUN_START)
 
-    // The run start part
-    c->vel.x += delta * c->acc.x;
+#define CHARACTER_TICKS_RUN_JUMP(X) \
+    X(Peak, None, RUN_FALL)
 
-    if (SDL_fabsf(c->vel.x) >= PLAYER_X_VEL_MAX) {
-        c->vel.x = PLAYER_X_VEL_MAX * (c->vel.x > 0 ? 1.0f : -1.0f);
-        *opts |= (c->vel.x > 0 ? CHARACTER_MOVE_RIGHT : CHARACTER_MOVE_LEFT);
-        ret = SC_CHARACTER_RUN;
-    }
+#define CHARACTER_TICKS_RUN_FALL(X) \
+    X(Landed, Vel, RUN)
 
-    c->pos.x += delta * c->vel.x;
-    return ret;
-}
+#define CHARACTER_TICKS_RUN_STOP_JUMP(X) \
+    X(Stopped, None, STAND_JUMP) \
+    X(Peak,    Acc,  RUN_STOP_FALL)
 
-void CharacterEnterRunStop(void *el, Uint64 *opts)
-{
-    SC_Character *c = el;
-    float dir = (*opts & CHARACTER_MOVE_RIGHT) > 0 ? -1.0f : 1.0f;
-    if (dir < 0 && c->vel.x < 0) {
-        dir = 1.0f;
-    } else if (dir > 0 && c->vel.x > 0) {
-        dir = -1.0f;
-    }
-    c->acc.x = dir * PLAYER_X_ACC_STOP;
-    c->vel.y = 0;
-    c->acc.y = 0;
-}
+#define CHARACTER_TICKS_RUN_STOP_FALL(X) \
+    X(Stopped, None, STAND_FALL) \
+    X(Landed,  Vel,  RUN_STOP)
 
-void CharacterExitRunStop(void *el, Uint64 *opts)
-{
-}
+// Horizontal halves of entering a state
 
-int CharacterInputRunStop(void *el, SC_Event e, Uint64 now, Uint64 *opts)
+static inline void characterEnterXStop(SC_Characters *c, Uint32 i, Uint64 *opts)
 {
-    SC_Character *c = el;
-
-    if (e == SC_EVENT_RUN_START) {
-        return SC_CHARACTER_RUN_START;
-    } else if (e == SC_EVENT_RUN_STOP) {
-        // If both left and right were down, update *opts with
-        // correct direction to move
-        Uint64 optUpdate =  (*opts & CHARACTER_MOVE_RIGHT) > 0 ? CHARACTER_MOVE_LEFT : CHARACTER_MOVE_RIGHT;
-        *opts &= ~*opts;
-        *opts |= optUpdate;
-        return SC_CHARACTER_RUN_START;
-    } else if (e == SC_EVENT_JUMP) {
-        *opts |= c->vel.x > 0 ? CHARACTER_MOVE_RIGHT : CHARACTER_MOVE_LEFT;
-        return SC_CHARACTER_RUN_STOP_JUMP;
-    }
-    return SC_FSM_NO_CHANGE;
-}
-
-int CharacterTickRunStop(void *el, Uint64 delta, Uint64 now, Uint64 *opts)
-{
-    SC_Character *c = el;
-
-    float dir = c->acc.x > 0 ? -1.0f : 1.0f;
-    c->vel.x += delta * c->acc.x;
-
-    if (SDL_fabsf(dir * PLAYER_X_VEL_MAX - c->vel.x) >= PLAYER_X_VEL_MAX) {
-        return SC_CHARACTER_STAND;
-    }
-
-    c->pos.x += delta * c->vel.x;
-
-    return SC_FSM_NO_CHANGE;
+    c->velX[i] = 0;
+    c->accX[i] = 0;
 }
 
-void CharacterEnterStandJump(void *el, Uint64 *opts)
+static inline void characterEnterXStart(SC_Characters *c, Uint32 i, Uint64 *opts)
 {
-    SC_Character *c = el;
-    c->vel.x = 0;
-    if (c->vel.y == 0) {
-        c->vel.y = PLAYER_Y_VEL_START;
+    int dir = (*opts & CHARACTER_MOVE_RIGHT) > 0 ? 1 : -1;
+    if (c->velX[i] == 0) {
+        c->velX[i] = dir * c->tuning.xVelStart;
     }
-
-    c->acc.y = PLAYER_Y_ACC;
+    c->flags[i] = dir > 0 ? CHARACTER_FLAG_FACE_RIGHT : CHARACTER_FLAG_FACE_LEFT;
+    c->accX[i] = dir * c->tuning.xAccRun;
 }
 
-void CharacterExitStandJump(void *el, Uint64 *opts)
+static inline void characterEnterXRun(SC_Characters *c, Uint32 i, Uint64 *opts)
 {
+    int dir = (*opts & CHARACTER_MOVE_RIGHT) > 0 ? 1 : -1;
+    c->velX[i] = dir * c->tuning.xVelMax;
+    c->accX[i] = 0;
 }
 
-int CharacterInputStandJump(void *el, SC_Event e, Uint64 now, Uint64 *opts)
+// Running in the air keeps whatever speed the character had
+static inline void characterEnterXCoast(SC_Characters *c, Uint32 i, Uint64 *opts)
 {
-    SC_Character *c = el;
-
-    if (e == SC_EVENT_RUN_START) {
-        return SC_CHARACTER_RUN_START_JUMP;
-    } else if (e == SC_EVENT_RUN_STOP) {
-        // If both left and right were down, update *opts with
-        // correct direction to move
-        Uint64 optUpdate =  (*opts & CHARACTER_MOVE_RIGHT) > 0 ? CHARACTER_MOVE_LEFT : CHARACTER_MOVE_RIGHT;
-        *opts &= ~*opts;
-        *opts |= optUpdate;
-        return SC_CHARACTER_RUN_START_JUMP;
-    } else if (e == SC_EVENT_JUMP_STOP) {
-        if (c->vel.y < PLAYER_Y_VEL_STOP) {
-            c->vel.y = PLAYER_Y_VEL_STOP;
-        }
-        return SC_CHARACTER_STAND_FALL;
-    }
-
-    return SC_FSM_NO_CHANGE;
+    c->accX[i] = 0;
 }
 
-int CharacterTickStandJump(void *el, Uint64 delta, Uint64 now, Uint64 *opts)
+// Decelerates against the current velocity, whichever direction the opts say
+static inline void characterEnterXBrake(SC_Characters *c, Uint32 i, Uint64 *opts)
 {
-    SC_Character *c = el;
-    c->vel.y += delta * c->acc.y;
-
-    if (c->vel.y >= 0) {
-        return SC_CHARACTER_STAND_FALL;
+    int dir = (*opts & CHARACTER_MOVE_RIGHT) > 0 ? -1 : 1;
+    if (dir < 0 && c->velX[i] < 0) {
+        dir = 1;
+    } else if (dir > 0 && c->velX[i] > 0) {
+        dir = -1;
     }
-
-    c->pos.y += delta * c->vel.y;
-    return SC_FSM_NO_CHANGE;
+    c->accX[i] = dir * c->tuning.xAccStop;
 }
 
-void CharacterEnterStandFall(void *el, Uint64 *opts)
-{
-    SC_Character *c = el;
-    c->vel.x = 0;
-    c->acc.y = PLAYER_Y_ACC;
-}
+// Vertical halves
 
-void CharacterExitStandFall(void *el, Uint64 *opts)
+static inline void characterEnterYGround(SC_Characters *c, Uint32 i)
 {
+    c->velY[i] = 0;
+    c->accY[i] = 0;
 }
 
-int CharacterInputStandFall(void *el, SC_Event e, Uint64 now, Uint64 *opts)
+// Only a jump from the ground gets the initial velocity, changing direction
+// mid-jump re-enters a jump state without it
+static inline void characterEnterYJump(SC_Characters *c, Uint32 i)
 {
-    if (e == SC_EVENT_RUN_START) {
-        return SC_CHARACTER_RUN_START_FALL;
-    } else if (e == SC_EVENT_RUN_STOP) {
-        // If both left and right were down, update *opts with
-        // correct direction to move
-        Uint64 optUpdate =  (*opts & CHARACTER_MOVE_RIGHT) > 0 ? CHARACTER_MOVE_LEFT : CHARACTER_MOVE_RIGHT;
-        *opts &= ~*opts;
-        *opts |= optUpdate;
-        return SC_CHARACTER_RUN_START_FALL;
+    if (c->velY[i] == 0) {
+        c->velY[i] = c->tuning.yVelStart;
     }
-    return SC_FSM_NO_CHANGE;
+    c->accY[i] = c->tuning.yAcc;
 }
 
-int CharacterTickStandFall(void *el, Uint64 delta, Uint64 now, Uint64 *opts)
+static inline void characterEnterYFall(SC_Characters *c, Uint32 i)
 {
-    SC_Character *c = el;
-    c->vel.y += delta * c->acc.y;
-
-    if (c->vel.y >= PLAYER_Y_VEL_MAX) {
-        c->vel.y = PLAYER_Y_VEL_MAX;
-    }
-
-    c->pos.y += delta * c->vel.y;
-
-    if (c->pos.y >= GROUND_Y) {
-        c->pos.y = GROUND_Y;
-        return SC_CHARACTER_STAND;
-    }
-    return SC_FSM_NO_CHANGE;
+    c->accY[i] = c->tuning.yAcc;
 }
 
-void CharacterEnterRunStartJump(void *el, Uint64 *opts)
-{
-    SC_Character *c = el;
-    float dir = (*opts & CHARACTER_MOVE_RIGHT) > 0 ? 1.0f : -1.0f;
-
-    if (c->vel.x == 0) {
-        c->vel.x = dir * PLAYER_X_VEL_START;
-    }
-
-    c->flags = dir > 0 ? CHARACTER_FLAG_FACE_RIGHT : CHARACTER_FLAG_FACE_LEFT;
-
-    c->acc.x = dir * PLAYER_X_ACC_RUN;
-
-    if (c->vel.y == 0) {
-        c->vel.y = PLAYER_Y_VEL_START;
-    }
-
-    c->acc.y = PLAYER_Y_ACC;
-}
+// Actions, run before moving to the target state
 
-void CharacterExitRunStartJump(void *el, Uint64 *opts)
+static inline void characterDoNone(SC_Characters *c, Uint32 i, Uint64 *opts)
 {
 }
 
-int CharacterInputRunStartJump(void *el, SC_Event e, Uint64 now, Uint64 *opts)
+static inline void characterDoFlip(SC_Characters *c, Uint32 i, Uint64 *opts)
 {
-    SC_Character *c = el;
-
-    if (e == SC_EVENT_RUN_STOP) {
-        return SC_CHARACTER_RUN_STOP_JUMP;
-    } else if (e == SC_EVENT_RUN_START) {
-        // If both left and right were down, update *opts with
-        // correct move direction
-        *opts &= ~(c->vel.x > 0 ? CHARACTER_MOVE_LEFT : CHARACTER_MOVE_RIGHT);
-        *opts |= c->vel.x > 0 ? CHARACTER_MOVE_RIGHT : CHARACTER_MOVE_LEFT;
-        return SC_CHARACTER_RUN_STOP_JUMP;
-    } else if (e == SC_EVENT_JUMP_STOP) {
-        if (c->vel.y < PLAYER_Y_VEL_STOP) {
-            c->vel.y = PLAYER_Y_VEL_STOP;
-        }
-        *opts |= c->acc.x > 0 ? CHARACTER_MOVE_RIGHT : CHARACTER_MOVE_LEFT;
-        return SC_CHARACTER_RUN_START_FALL;
-    }
-
-    return SC_FSM_NO_CHANGE;
+    *opts = (*opts & CHARACTER_MOVE_RIGHT) > 0 ? CHARACTER_MOVE_LEFT : CHARACTER_MOVE_RIGHT;
 }
 
-int CharacterTickRunStartJump(void *el, Uint64 delta, Uint64 now, Uint64 *opts)
+static inline void characterDoKeep(SC_Characters *c, Uint32 i, Uint64 *opts)
 {
-    SC_Character *c = el;
-
-    // The run start part
-    c->vel.x += delta * c->acc.x;
-
-    if (SDL_fabsf(c->vel.x) >= PLAYER_X_VEL_MAX) {
-        c->vel.x = PLAYER_X_VEL_MAX * (c->vel.x > 0 ? 1.0f : -1.0f);
-        *opts |= (c->vel.x > 0 ? CHARACTER_MOVE_RIGHT : CHARACTER_MOVE_LEFT);
-        return SC_CHARACTER_RUN_JUMP;
-    }
-
-    c->pos.x += delta * c->vel.x;
-
-    // The jump part
-    c->vel.y += delta * c->acc.y;
-
-    if (c->vel.y >= 0) {
-        *opts |= c->acc.x > 0 ? CHARACTER_MOVE_RIGHT : CHARACTER_MOVE_LEFT;
-        return SC_CHARACTER_RUN_START_FALL;
-    }
-
-    c->pos.y += delta * c->vel.y;
-    return SC_FSM_NO_CHANGE;
+    *opts &= ~(c->velX[i] > 0 ? CHARACTER_MOVE_LEFT : CHARACTER_MOVE_RIGHT);
+    *opts |= c->velX[i] > 0 ? CHARACTER_MOVE_RIGHT : CHARACTER_MOVE_LEFT;
 }
 
-void CharacterEnterRunStartFall(void *el, Uint64 *opts)
+static inline void characterDoAcc(SC_Characters *c, Uint32 i, Uint64 *opts)
 {
-    SC_Character *c = el;
-    float dir = (*opts & CHARACTER_MOVE_RIGHT) > 0 ? 1.0f : -1.0f;
-    if (c->vel.x == 0) {
-        c->vel.x = dir * PLAYER_X_VEL_START;
-    }
-
-    c->flags = dir > 0 ? CHARACTER_FLAG_FACE_RIGHT : CHARACTER_FLAG_FACE_LEFT;
-
-    c->acc.x = dir * PLAYER_X_ACC_RUN;
-
-    c->acc.y = PLAYER_Y_ACC;
+    *opts |= c->accX[i] > 0 ? CHARACTER_MOVE_RIGHT : CHARACTER_MOVE_LEFT;
 }
 
-void CharacterExitRunStartFall(void *el, Uint64 *opts)
+static inline void characterDoVel(SC_Characters *c, Uint32 i, Uint64 *opts)
 {
+    *opts |= c->velX[i] > 0 ? CHARACTER_MOVE_RIGHT : CHARACTER_MOVE_LEFT;
 }
 
-int CharacterInputRunStartFall(void *el, SC_Event e, Uint64 now, Uint64 *opts)
+// Letting go of jump early cuts the rise short
+static inline void characterDoCut(SC_Characters *c, Uint32 i, Uint64 *opts)
 {
-    SC_Character *c = el;
-
-    if (e == SC_EVENT_RUN_STOP) {
-        return SC_CHARACTER_RUN_STOP_FALL;
-    } else if (e == SC_EVENT_RUN_START) {
-        // If both left and right were down, update *opts with
-        // correct move direction
-        *opts &= ~(c->vel.x > 0 ? CHARACTER_MOVE_LEFT : CHARACTER_MOVE_RIGHT);
-        *opts |= c->vel.x > 0 ? CHARACTER_MOVE_RIGHT : CHARACTER_MOVE_LEFT;
-        return SC_CHARACTER_RUN_STOP_FALL;
+    if (c->velY[i] < c->tuning.yVelStop) {
+        c->velY[i] = c->tuning.yVelStop;
     }
-
-    return SC_FSM_NO_CHANGE;
 }
 
-int CharacterTickRunStartFall(void *el, Uint64 delta, Uint64 now, Uint64 *opts)
+static inline void characterDoCutAcc(SC_Characters *c, Uint32 i, Uint64 *opts)
 {
-    SC_Character *c = el;
-
-    // The run start part
-    c->vel.x += delta * c->acc.x;
-
-    if (SDL_fabsf(c->vel.x) >= PLAYER_X_VEL_MAX) {
-        c->vel.x = PLAYER_X_VEL_MAX * (c->vel.x > 0 ? 1.0f : -1.0f);
-        *opts |= (c->vel.x > 0 ? CHARACTER_MOVE_RIGHT : CHARACTER_MOVE_LEFT);
-        return SC_CHARACTER_RUN_FALL;
-    }
-
-    c->pos.x += delta * c->vel.x;
-
-    // Fall part
-    c->vel.y += delta * c->acc.y;
-
-    if (c->vel.y >= PLAYER_Y_VEL_MAX) {
-        c->vel.y = PLAYER_Y_VEL_MAX;
-    }
-
-    c->pos.y += delta * c->vel.y;
-
-    if (c->pos.y >= GROUND_Y) {
-        c->pos.y = GROUND_Y;
-        *opts |= (c->acc.x > 0 ? CHARACTER_MOVE_RIGHT : CHARACTER_MOVE_LEFT);
-        return SC_CHARACTER_RUN_START;
-    }
-
-    return SC_FSM_NO_CHANGE;
+    characterDoCut(c, i, opts);
+    characterDoAcc(c, i, opts);
 }
 
-void CharacterEnterRunJump(void *el, Uint64 *opts)
+static inline void characterDoCutBrake(SC_Characters *c, Uint32 i, Uint64 *opts)
 {
-    SC_Character *c = el;
-    if (c->vel.y == 0) {
-        c->vel.y = PLAYER_Y_VEL_START;
-    }
-    c->acc.y = PLAYER_Y_ACC;
+    characterDoCut(c, i, opts);
+    *opts |= c->accX[i] < 0 ? CHARACTER_MOVE_RIGHT : CHARACTER_MOVE_LEFT;
 }
 
-void CharacterExitRunJump(void *el, Uint64 *opts)
-{
-}
+// Tick conditions. Position and velocity were already integrated this tick.
 
-int CharacterInputRunJump(void *el, SC_Event e, Uint64 now, Uint64 *opts)
+// Walked or was pushed off a platform
+static inline bool characterIfOffFloor(SC_Characters *c, Uint32 i)
 {
-    SC_Character *c = el;
-
-    if (e == SC_EVENT_RUN_STOP) {
-        return SC_CHARACTER_RUN_STOP_JUMP;
-    } else if (e == SC_EVENT_RUN_START) {
-        *opts &= ~(c->vel.x > 0 ? CHARACTER_MOVE_LEFT : CHARACTER_MOVE_RIGHT);
-        *opts |= c->vel.x > 0 ? CHARACTER_MOVE_RIGHT : CHARACTER_MOVE_LEFT;
-        return SC_CHARACTER_RUN_STOP_JUMP;
-    } else if (e == SC_EVENT_JUMP_STOP) {
-        if (c->vel.y < PLAYER_Y_VEL_STOP) {
-            c->vel.y = PLAYER_Y_VEL_STOP;
-        }
-        return SC_CHARACTER_RUN_FALL;
-    }
-
-    return SC_FSM_NO_CHANGE;
+    return c->posY[i] < c->floorY[i];
 }
 
-int CharacterTickRunJump(void *el, Uint64 delta, Uint64 now, Uint64 *opts)
+static inline bool characterIfLanded(SC_Characters *c, Uint32 i)
 {
-    SC_Character *c = el;
-    c->pos.x += delta * c->vel.x;
-
-    c->vel.y += delta * c->acc.y;
-
-    if (c->vel.y >= 0) {
-        return SC_CHARACTER_RUN_FALL;
+    if (c->posY[i] >= c->floorY[i]) {
+        c->posY[i] = c->floorY[i];
+        return true;
     }
-
-    c->pos.y += delta * c->vel.y;
-    return SC_FSM_NO_CHANGE;
+    return false;
 }
 
-void CharacterEnterRunFall(void *el, Uint64 *opts)
+// integrateCharacters clamps vel.x to xVelMax
+static inline bool characterIfAtMax(SC_Characters *c, Uint32 i)
 {
-    SC_Character *c = el;
-    c->acc.y = PLAYER_Y_ACC;
+    return REAL_ABS(c->velX[i]) >= c->tuning.xVelMax;
 }
 
-void CharacterExitRunFall(void *el, Uint64 *opts)
+// vel.x has crossed zero
+static inline bool characterIfStopped(SC_Characters *c, Uint32 i)
 {
+    int dir = c->accX[i] > 0 ? -1 : 1;
+    return REAL_ABS(dir * c->tuning.xVelMax - c->velX[i]) >= c->tuning.xVelMax;
 }
 
-int CharacterInputRunFall(void *el, SC_Event e, Uint64 now, Uint64 *opts)
+static inline bool characterIfPeak(SC_Characters *c, Uint32 i)
 {
-    SC_Character *c = el;
-
-    if (e == SC_EVENT_RUN_STOP) {
-        return SC_CHARACTER_RUN_STOP_FALL;
-    } else if (e == SC_EVENT_RUN_START) {
-        *opts &= ~(c->vel.x > 0 ? CHARACTER_MOVE_LEFT : CHARACTER_MOVE_RIGHT);
-        *opts |= c->vel.x > 0 ? CHARACTER_MOVE_RIGHT : CHARACTER_MOVE_LEFT;
-        return SC_CHARACTER_RUN_STOP_FALL;
-    }
-
-    return SC_FSM_NO_CHANGE;
+    return c->velY[i] >= 0;
 }
 
-int CharacterTickRunFall(void *el, Uint64 delta, Uint64 now, Uint64 *opts)
-{
-    SC_Character *c = el;
-    c->pos.x += delta * c->vel.x;
-
-    c->vel.y += delta * c->acc.y;
+// Per-state input and tick functions, one `if` per table row
 
-    if (c->vel.y >= PLAYER_Y_VEL_MAX) {
-        c->vel.y = PLAYER_Y_VEL_MAX;
+#define CHARACTER_INPUT_ROW(event, action, target) \
+    if (e == SC_EVENT_##event) { \
+        characterDo##action(c, i, opts); \
+        return SC_CHARACTER_##target; \
     }
 
-    c->pos.y += delta * c->vel.y;
-
-    if (c->pos.y >= GROUND_Y) {
-        c->pos.y = GROUND_Y;
-        *opts |= (c->vel.x > 0 ? CHARACTER_MOVE_RIGHT : CHARACTER_MOVE_LEFT);
-        return SC_CHARACTER_RUN;
+#define CHARACTER_TICK_ROW(condition, action, target) \
+    if (characterIf##condition(c, i)) { \
+        characterDo##action(c, i, opts); \
+        return SC_CHARACTER_##target; \
     }
 
-    return SC_FSM_NO_CHANGE;
-}
-
-void CharacterEnterRunStopJump(void *el, Uint64 *opts)
-{
-    SC_Character *c = el;
-    float dir = (*opts & CHARACTER_MOVE_RIGHT) > 0 ? -1.0f : 1.0f;
-
-    if (dir < 0 && c->vel.x < 0) {
-        dir = 1.0f;
-    } else if (dir > 0 && c->vel.x > 0) {
-        dir = -1.0f;
+#define CHARACTER_STATE_FUNCTIONS(id, name, horizontal, vertical) \
+    static inline void characterEnter##name(SC_Characters *c, Uint32 i, Uint64 *opts) \
+    { \
+        characterEnterX##horizontal(c, i, opts); \
+        characterEnterY##vertical(c, i); \
+    } \
+    static inline int characterInput##name(SC_Characters *c, Uint32 i, SC_Event e, Uint64 *opts) \
+    { \
+        CHARACTER_INPUTS_##id(CHARACTER_INPUT_ROW) \
+        return SC_FSM_NO_CHANGE; \
+    } \
+    static inline int characterTick##name(SC_Characters *c, Uint32 i, Uint64 *opts) \
+    { \
+        CHARACTER_TICKS_##id(CHARACTER_TICK_ROW) \
+        return SC_FSM_NO_CHANGE; \
     }
 
-    c->acc.x = dir * PLAYER_X_ACC_STOP;
+CHARACTER_STATES(CHARACTER_STATE_FUNCTIONS)
 
-    if (c->vel.y == 0) {
-        c->vel.y = PLAYER_Y_VEL_START;
-    }
-
-    c->acc.y = PLAYER_Y_ACC;
-}
+// Switch-based dispatch
 
-void CharacterExitRunStopJump(void *el, Uint64 *opts)
-{
-}
+#define CHARACTER_ENTER_CASE(id, name, horizontal, vertical) \
+    case SC_CHARACTER_##id: characterEnter##name(c, i, opts); break;
 
-int CharacterInputRunStopJump(void *el, SC_Event e, Uint64 now, Uint64 *opts)
-{
-    SC_Character *c = el;
-
-    if (e == SC_EVENT_RUN_START) {
-        return SC_CHARACTER_RUN_START_JUMP;
-    } else if (e == SC_EVENT_RUN_STOP) {
-        // If both left and right were down, update *opts with
-        // correct direction to move
-        Uint64 optUpdate =  (*opts & CHARACTER_MOVE_RIGHT) > 0 ? CHARACTER_MOVE_LEFT : CHARACTER_MOVE_RIGHT;
-        *opts &= ~*opts;
-        *opts |= optUpdate;
-        return SC_CHARACTER_RUN_START_JUMP;
-    } else if (e == SC_EVENT_JUMP_STOP) {
-        if (c->vel.y < PLAYER_Y_VEL_STOP) {
-            c->vel.y = PLAYER_Y_VEL_STOP;
-        }
-        *opts |= c->acc.x < 0 ? CHARACTER_MOVE_RIGHT : CHARACTER_MOVE_LEFT;
-        return SC_CHARACTER_RUN_STOP_FALL;
-    }
+#define CHARACTER_INPUT_CASE(id, name, horizontal, vertical) \
+    case SC_CHARACTER_##id: return characterInput##name(c, i, e, opts);
 
-    return SC_FSM_NO_CHANGE;
-}
+#define CHARACTER_TICK_CASE(id, name, horizontal, vertical) \
+    case SC_CHARACTER_##id: return characterTick##name(c, i, opts);
 
-int CharacterTickRunStopJump(void *el, Uint64 delta, Uint64 now, Uint64 *opts)
+// Moves character i into `state`. There are no exit actions to run first.
+static inline void characterTransition(SC_Characters *c, Uint32 i, int state, Uint64 *opts)
 {
-    SC_Character *c = el;
-
-    // The run stop part
-    float dir = c->acc.x > 0 ? -1.0f : 1.0f;
-    c->vel.x += delta * c->acc.x;
-
-    if (SDL_fabsf(dir * PLAYER_X_VEL_MAX - c->vel.x) >= PLAYER_X_VEL_MAX) {
-        return SC_CHARACTER_STAND_JUMP;
-    }
-
-    c->pos.x += delta * c->vel.x;
+    c->state[i] = state;
 
-    // The jump part
-    c->vel.y += delta * c->acc.y;
-
-    if (c->vel.y >= 0) {
-        *opts |= (c->acc.x > 0 ? CHARACTER_MOVE_RIGHT : CHARACTER_MOVE_LEFT);
-        return SC_CHARACTER_RUN_STOP_FALL;
+    switch (state) {
+    CHARACTER_STATES(CHARACTER_ENTER_CASE)
     }
-
-    c->pos.y += delta * c->vel.y;
-    return SC_FSM_NO_CHANGE;
 }
 
-void CharacterEnterRunStopFall(void *el, Uint64 *opts)
+static inline int characterInput(SC_Characters *c, Uint32 i, SC_Event e, Uint64 *opts)
 {
-    SC_Character *c = el;
-    float dir = (*opts & CHARACTER_MOVE_RIGHT) > 0 ? -1.0f : 1.0f;
-
-    if (dir < 0 && c->vel.x < 0) {
-        dir = 1.0f;
-    } else if (dir > 0 && c->vel.x > 0) {
-        dir = -1.0f;
+    switch (c->state[i]) {
+    CHARACTER_STATES(CHARACTER_INPUT_CASE)
     }
-
-    c->acc.x = dir * PLAYER_X_ACC_STOP;
-    c->acc.y = PLAYER_Y_ACC;
-}
-
-void CharacterExitRunStopFall(void *el, Uint64 *opts)
-{
+    return SC_FSM_NO_CHANGE;
 }
 
-int CharacterInputRunStopFall(void *el, SC_Event e, Uint64 now, Uint64 *opts)
+static inline int characterTick(SC_Characters *c, Uint32 i, Uint64 *opts)
 {
-    if (e == SC_EVENT_RUN_START) {
-        return SC_CHARACTER_RUN_START_FALL;
-    } else if (e == SC_EVENT_RUN_STOP) {
-        // If both left and right were down, update *opts with
-        // correct direction to move
-        Uint64 optUpdate =  (*opts & CHARACTER_MOVE_RIGHT) > 0 ? CHARACTER_MOVE_LEFT : CHARACTER_MOVE_RIGHT;
-        *opts &= ~*opts;
-        *opts |= optUpdate;
-        return SC_CHARACTER_RUN_START_FALL;
+    switch (c->state[i]) {
+    CHARACTER_STATES(CHARACTER_TICK_CASE)
     }
-
     return SC_FSM_NO_CHANGE;
 }
 
-int CharacterTickRunStopFall(void *el, Uint64 delta, Uint64 now, Uint64 *opts)
-{
-    SC_Character *c = el;
+// Same as SC_FSM_TICK_BATCH, with the state's tick inlined into the loop
+#define CHARACTER_TICK_BATCH_CASE(id, name, horizontal, vertical) \
+    case SC_CHARACTER_##id: \
+        for (Uint32 k = 0; k < n; k++) { \
+            Uint64 opts = 0; \
+            int newState = characterTick##name(c, is[k], &opts); \
+            if (newState != SC_FSM_NO_CHANGE) { \
+                out[numOut].i = is[k]; \
+                out[numOut].state = newState; \
+                out[numOut].opts = opts; \
+                numOut++; \
+            } \
+        } \
+        break;
 
-    // The run stop part
-    float dir = c->acc.x > 0 ? -1.0f : 1.0f;
-    c->vel.x += delta * c->acc.x;
+// Ticks the n characters in `is`, which must all be in `state`
+Uint32 tickCharacterBatch(SC_Characters *c, int state, const Uint32 *is, Uint32 n, SC_Transition *out)
+{
+    Uint32 numOut = 0;
 
-    if (SDL_fabsf(dir * PLAYER_X_VEL_MAX - c->vel.x) >= PLAYER_X_VEL_MAX) {
-        return SC_CHARACTER_STAND_FALL;
+    switch (state) {
+    CHARACTER_STATES(CHARACTER_TICK_BATCH_CASE)
     }
 
-    c->pos.x += delta * c->vel.x;
-
-    // Fall part
-    c->vel.y += delta * c->acc.y;
+    return numOut;
+}
 
-    if (c->vel.y >= PLAYER_Y_VEL_MAX) {
-        c->vel.y = PLAYER_Y_VEL_MAX;
-    }
+// The SC_FSM table, for callers that go through function pointers
 
-    c->pos.y += delta * c->vel.y;
+#define CHARACTER_FSM_FUNCTIONS(id, name, horizontal, vertical) \
+    void CharacterEnter##name(void *el, Uint32 i, Uint64 *opts) \
+    { \
+        characterEnter##name(el, i, opts); \
+    } \
+    int CharacterInput##name(void *el, Uint32 i, SC_Event e, Uint64 now, Uint64 *opts) \
+    { \
+        return characterInput##name(el, i, e, opts); \
+    } \
+    int CharacterTick##name(void *el, Uint32 i, Uint64 delta, Uint64 now, Uint64 *opts) \
+    { \
+        return characterTick##name(el, i, opts); \
+    } \
+    SC_FSM_TICK_BATCH(CharacterTick##name)
 
-    if (c->pos.y >= GROUND_Y) {
-        c->pos.y = GROUND_Y;
-        *opts |= (c->vel.x > 0 ? CHARACTER_MOVE_RIGHT : CHARACTER_MOVE_LEFT);
-        return SC_CHARACTER_RUN_STOP;
-    }
+CHARACTER_STATES(CHARACTER_FSM_FUNCTIONS)
 
-    return SC_FSM_NO_CHANGE;
+void CharacterExitNone(void *el, Uint32 i, Uint64 *opts)
+{
 }
 
+#define CHARACTER_FSM_ENTRY(id, name, horizontal, vertical) \
+    FSMsCharacter[SC_CHARACTER_##id] = (SC_FSM) { \
+        .enter = CharacterEnter##name, \
+        .exit = CharacterExitNone, \
+        .input = CharacterInput##name, \
+        .tick = CharacterTick##name, \
+        .tickBatch = CharacterTick##name##Batch, \
+    };
+
 void initCharacterFSM()
 {
     FSMsCharacter = (SC_FSM *) SDL_calloc(SC_CHARACTER_MOVE_STATE_TOTAL, sizeof(SC_FSM));
-
-    SC_FSM *stand = FSMsCharacter + SC_CHARACTER_STAND;
-    stand->enter = CharacterEnterStand;
-    stand->exit = CharacterExitStand;
-    stand->input = CharacterInputStand;
-    stand->tick = CharacterTickStand;
-
-    SC_FSM *run = FSMsCharacter + SC_CHARACTER_RUN;
-    run->enter = CharacterEnterRun;
-    run->exit = CharacterExitRun;
-    run->input = CharacterInputRun;
-    run->tick = CharacterTickRun;
-
-    SC_FSM *runStart = FSMsCharacter + SC_CHARACTER_RUN_START;
-    runStart->enter = CharacterEnterRunStart;
-    runStart->exit = CharacterExitRunStart;
-    runStart->input = CharacterInputRunStart;
-    runStart->tick = CharacterTickRunStart;
-
-    SC_FSM *runStop = FSMsCharacter + SC_CHARACTER_RUN_STOP;
-    runStop->enter = CharacterEnterRunStop;
-    runStop->exit = CharacterExitRunStop;
-    runStop->input = CharacterInputRunStop;
-    runStop->tick = CharacterTickRunStop;
-
-    SC_FSM *standJump = FSMsCharacter + SC_CHARACTER_STAND_JUMP;
-    standJump->enter = CharacterEnterStandJump;
-    standJump->exit = CharacterExitStandJump;
-    standJump->input = CharacterInputStandJump;
-    standJump->tick = CharacterTickStandJump;
-
-    SC_FSM *standFall = FSMsCharacter + SC_CHARACTER_STAND_FALL;
-    standFall->enter = CharacterEnterStandFall;
-    standFall->exit = CharacterExitStandFall;
-    standFall->input = CharacterInputStandFall;
-    standFall->tick = CharacterTickStandFall;
-
-    SC_FSM *runStartJump = FSMsCharacter + SC_CHARACTER_RUN_START_JUMP;
-    runStartJump->enter = CharacterEnterRunStartJump;
-    runStartJump->exit = CharacterExitRunStartJump;
-    runStartJump->input = CharacterInputRunStartJump;
-    runStartJump->tick = CharacterTickRunStartJump;
-
-    SC_FSM *runStartFall = FSMsCharacter + SC_CHARACTER_RUN_START_FALL;
-    runStartFall->enter = CharacterEnterRunStartFall;
-    runStartFall->exit = CharacterExitRunStartFall;
-    runStartFall->input = CharacterInputRunStartFall;
-    runStartFall->tick = CharacterTickRunStartFall;
-
-    SC_FSM *runJump = FSMsCharacter + SC_CHARACTER_RUN_JUMP;
-    runJump->enter = CharacterEnterRunJump;
-    runJump->exit = CharacterExitRunJump;
-    runJump->input = CharacterInputRunJump;
-    runJump->tick = CharacterTickRunJump;
-
-    SC_FSM *runFall = FSMsCharacter + SC_CHARACTER_RUN_FALL;
-    runFall->enter = CharacterEnterRunFall;
-    runFall->exit = CharacterExitRunFall;
-    runFall->input = CharacterInputRunFall;
-    runFall->tick = CharacterTickRunFall;
-
-    SC_FSM *runStopJump = FSMsCharacter + SC_CHARACTER_RUN_STOP_JUMP;
-    runStopJump->enter = CharacterEnterRunStopJump;
-    runStopJump->exit = CharacterExitRunStopJump;
-    runStopJump->input = CharacterInputRunStopJump;
-    runStopJump->tick = CharacterTickRunStopJump;
-
-    SC_FSM *runStopFall = FSMsCharacter + SC_CHARACTER_RUN_STOP_FALL;
-    runStopFall->enter = CharacterEnterRunStopFall;
-    runStopFall->exit = CharacterExitRunStopFall;
-    runStopFall->input = CharacterInputRunStopFall;
-    runStopFall->tick = CharacterTickRunStopFall;
+    CHARACTER_STATES(CHARACTER_FSM_ENTRY)
 }
 
 void destroyCharacterFSM()
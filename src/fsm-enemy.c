@@ -0,0 +1,206 @@
+#include <SDL3/SDL.h>
+#include "fsm.h"
+#include "types.h"
+
+// Units are px and ms, like the player's
+#define ENEMY_Y_ACC     REAL(0.00214)
+#define ENEMY_Y_VEL_MAX REAL(0.8025)
+#define ENEMY_SPEED_MAX REAL(0.24)
+#define ENEMY_DIE_VEL_Y REAL(-0.5)  // The hop a kicked enemy makes
+#define ENEMY_KICK_VEL  REAL(0.15)
+
+// Enemies are ENEMY_HALF_WIDTH either side of posX, standing on posY
+#define ENEMY_HALF_WIDTH REAL(16)
+#define ENEMY_HEIGHT     REAL(32)
+
+// In ticks
+#define ENEMY_FLIP_TICKS    300
+#define ENEMY_RECOVER_TICKS 60
+
+// Set in the opts of SC_EVENT_KICK to send the enemy flying right
+#define ENEMY_KICK_RIGHT 0b01
+
+// Walking speed of each kind
+static const SC_Real enemyKindSpeed[] = { REAL(0.06), REAL(0.09), REAL(0.12) };
+#define ENEMY_KIND_TOTAL ((Uint32) SDL_arraysize(enemyKindSpeed))
+
+// Generated from the tables below into switches the same way as the
+// character FSM, see fsm-character.c. Nothing goes through an SC_FSM table
+// for enemies, so there isn't one. Enemies don't get key input, their events come from
+// player contacts in collideEnemies. Gravity, landing and wrapping around
+// the playfield all happen in integrateEnemies, so the states only decide
+// what an enemy does on the ground.
+
+// id, Name
+#define ENEMY_STATES(X) \
+    X(WALK,    Walk) \
+    X(FALL,    Fall) \
+    X(FLIP,    Flip) \
+    X(RECOVER, Recover) \
+    X(DIE,     Die) \
+    X(GONE,    Gone)
+
+// Inputs: event, action, target
+#define ENEMY_INPUTS_WALK(X) \
+    X(STOMP, None, FLIP)
+
+#define ENEMY_INPUTS_FALL(X) \
+    X(STOMP, None, FLIP)
+
+#define ENEMY_INPUTS_FLIP(X) \
+    X(KICK, None, DIE)
+
+#define ENEMY_INPUTS_RECOVER(X) \
+    X(KICK, None, DIE)
+
+#define ENEMY_INPUTS_DIE(X)
+#define ENEMY_INPUTS_GONE(X)
+
+// Ticks, checked in order: condition, action, target
+#define ENEMY_TICKS_WALK(X) \
+    X(OffFloor, None, FALL)
+
+#define ENEMY_TICKS_FALL(X) \
+    X(Landed, None, WALK)
+
+#define ENEMY_TICKS_FLIP(X) \
+    X(TimeUp, None, RECOVER)
+
+#define ENEMY_TICKS_RECOVER(X) \
+    X(TimeUp, Anger, WALK)
+
+#define ENEMY_TICKS_DIE(X) \
+    X(OffScreen, None, GONE)
+
+#define ENEMY_TICKS_GONE(X)
+
+// Entering a state
+
+static inline void enemyEnterWalk(SC_Enemies *e, Uint32 i, Uint64 *opts)
+{
+    e->velX[i] = (e->flags[i] & CHARACTER_FLAG_FACE_RIGHT) > 0 ? e->speed[i] : -e->speed[i];
+}
+
+static inline void enemyEnterFall(SC_Enemies *e, Uint32 i, Uint64 *opts)
+{
+}
+
+static inline void enemyEnterFlip(SC_Enemies *e, Uint32 i, Uint64 *opts)
+{
+    e->velX[i] = 0;
+    e->timer[i] = ENEMY_FLIP_TICKS;
+}
+
+static inline void enemyEnterRecover(SC_Enemies *e, Uint32 i, Uint64 *opts)
+{
+    e->timer[i] = ENEMY_RECOVER_TICKS;
+}
+
+static inline void enemyEnterDie(SC_Enemies *e, Uint32 i, Uint64 *opts)
+{
+    e->velX[i] = (*opts & ENEMY_KICK_RIGHT) > 0 ? ENEMY_KICK_VEL : -ENEMY_KICK_VEL;
+    e->velY[i] = ENEMY_DIE_VEL_Y;
+}
+
+static inline void enemyEnterGone(SC_Enemies *e, Uint32 i, Uint64 *opts)
+{
+}
+
+// Actions
+
+static inline void enemyDoNone(SC_Enemies *e, Uint32 i, Uint64 *opts)
+{
+}
+
+// Every time an enemy gets back up it walks a quarter faster
+static inline void enemyDoAnger(SC_Enemies *e, Uint32 i, Uint64 *opts)
+{
+    e->speed[i] = SDL_min(e->speed[i] + e->speed[i] / 4, ENEMY_SPEED_MAX);
+}
+
+// Tick conditions. Position and velocity were already integrated this tick.
+
+static inline bool enemyIfOffFloor(SC_Enemies *e, Uint32 i)
+{
+    return e->posY[i] < e->floorY[i];
+}
+
+// integrateEnemies stops anything but a dying enemy at its floor
+static inline bool enemyIfLanded(SC_Enemies *e, Uint32 i)
+{
+    return e->posY[i] >= e->floorY[i];
+}
+
+static inline bool enemyIfTimeUp(SC_Enemies *e, Uint32 i)
+{
+    return --e->timer[i] == 0;
+}
+
+static inline bool enemyIfOffScreen(SC_Enemies *e, Uint32 i)
+{
+    return e->posY[i] > REAL_FROM_INT(SC_PLAYFIELD_HEIGHT) + ENEMY_HEIGHT;
+}
+
+// Per-state input and tick functions, one `if` per table row
+
+#define ENEMY_INPUT_ROW(event, action, target) \
+    if (ev == SC_EVENT_##event) { \
+        enemyDo##action(e, i, opts); \
+        return SC_ENEMY_##target; \
+    }
+
+#define ENEMY_TICK_ROW(condition, action, target) \
+    if (enemyIf##condition(e, i)) { \
+        enemyDo##action(e, i, opts); \
+        return SC_ENEMY_##target; \
+    }
+
+#define ENEMY_STATE_FUNCTIONS(id, name) \
+    static inline int enemyInput##name(SC_Enemies *e, Uint32 i, SC_Event ev, Uint64 *opts) \
+    { \
+        ENEMY_INPUTS_##id(ENEMY_INPUT_ROW) \
+        return SC_FSM_NO_CHANGE; \
+    } \
+    static inline int enemyTick##name(SC_Enemies *e, Uint32 i, Uint64 *opts) \
+    { \
+        ENEMY_TICKS_##id(ENEMY_TICK_ROW) \
+        return SC_FSM_NO_CHANGE; \
+    }
+
+ENEMY_STATES(ENEMY_STATE_FUNCTIONS)
+
+// Switch-based dispatch
+
+#define ENEMY_ENTER_CASE(id, name) \
+    case SC_ENEMY_##id: enemyEnter##name(e, i, opts); break;
+
+#define ENEMY_INPUT_CASE(id, name) \
+    case SC_ENEMY_##id: return enemyInput##name(e, i, ev, opts);
+
+#define ENEMY_TICK_CASE(id, name) \
+    case SC_ENEMY_##id: return enemyTick##name(e, i, opts);
+
+static inline void enemyTransition(SC_Enemies *e, Uint32 i, int state, Uint64 *opts)
+{
+    e->state[i] = state;
+
+    switch (state) {
+    ENEMY_STATES(ENEMY_ENTER_CASE)
+    }
+}
+
+static inline int enemyInput(SC_Enemies *e, Uint32 i, SC_Event ev, Uint64 *opts)
+{
+    switch (e->state[i]) {
+    ENEMY_STATES(ENEMY_INPUT_CASE)
+    }
+    return SC_FSM_NO_CHANGE;
+}
+
+static inline int enemyTick(SC_Enemies *e, Uint32 i, Uint64 *opts)
+{
+    switch (e->state[i]) {
+    ENEMY_STATES(ENEMY_TICK_CASE)
+    }
+    return SC_FSM_NO_CHANGE;
+}
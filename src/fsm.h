@@ -9,6 +9,8 @@ typedef enum SC_Event {
     SC_EVENT_JUMP,
     SC_EVENT_JUMP_STOP,
     SC_EVENT_FALL,
+    SC_EVENT_STOMP, // A player came down on an enemy
+    SC_EVENT_KICK,  // A player touched a flipped enemy
 } SC_Event;
 
 #define SC_FSM_NO_CHANGE -1
@@ -29,14 +31,53 @@ typedef enum SC_Event {
 //     the `opts`. But we want the character to start running to the right.
 //
 //     So we reverse the direction in the opts and return `SC_EVENT_RUN_START`.
+//
+// Why is there an index `i` next to `el`?
+//   - Elements are stored as a structure of arrays (see `SC_Characters`), so
+//     `el` points at the whole collection and `i` picks the element.
+//
+// Why don't the `tick` functions move anything?
+//   - Position and velocity are integrated for every element at once before
+//     the FSM runs (see `integrateCharacters`). `tick` only clamps and
+//     decides transitions.
+//
+// What is `tickBatch`?
+//   - The same `tick`, run over a list of `n` element indices in one call. It
+//     writes a `SC_Transition` for every element that wants to change state
+//     and returns how many it wrote; applying them is up to the caller. Define
+//     it with `SC_FSM_TICK_BATCH` so `tick` gets called directly.
+
+typedef struct SC_Transition {
+    Uint32 i;
+    Uint32 state;
+    Uint64 opts;
+} SC_Transition;
 
 typedef struct SC_FSM {
-    void (*enter)(void *el, Uint64 *opts);
-    void (*exit)(void *el, Uint64 *opts);
-    int (*input)(void *el, SC_Event e, Uint64 now, Uint64 *opts);
-    int (*tick)(void *el, Uint64 delta, Uint64 now, Uint64 *opts);
+    void (*enter)(void *el, Uint32 i, Uint64 *opts);
+    void (*exit)(void *el, Uint32 i, Uint64 *opts);
+    int (*input)(void *el, Uint32 i, SC_Event e, Uint64 now, Uint64 *opts);
+    int (*tick)(void *el, Uint32 i, Uint64 delta, Uint64 now, Uint64 *opts);
+    Uint32 (*tickBatch)(void *el, const Uint32 *is, Uint32 n, Uint64 delta, Uint64 now, SC_Transition *out);
 } SC_FSM;
 
+#define SC_FSM_TICK_BATCH(tickFn) \
+    Uint32 tickFn##Batch(void *el, const Uint32 *is, Uint32 n, Uint64 delta, Uint64 now, SC_Transition *out) \
+    { \
+        Uint32 numOut = 0; \
+        for (Uint32 k = 0; k < n; k++) { \
+            Uint64 opts = 0; \
+            int newState = tickFn(el, is[k], delta, now, &opts); \
+            if (newState != SC_FSM_NO_CHANGE) { \
+                out[numOut].i = is[k]; \
+                out[numOut].state = newState; \
+                out[numOut].opts = opts; \
+                numOut++; \
+            } \
+        } \
+        return numOut; \
+    }
+
 #define SC_CHARACTER_MOVE_STATE_TOTAL 12
 
 typedef enum SC_Character_State {
@@ -54,4 +95,15 @@ typedef enum SC_Character_State {
     SC_CHARACTER_RUN_STOP_FALL,
 } SC_Character_State;
 
+#define SC_ENEMY_STATE_TOTAL 6
+
+typedef enum SC_Enemy_State {
+    SC_ENEMY_WALK,
+    SC_ENEMY_FALL,
+    SC_ENEMY_FLIP,
+    SC_ENEMY_RECOVER,
+    SC_ENEMY_DIE,
+    SC_ENEMY_GONE,
+} SC_Enemy_State;
+
 #endif
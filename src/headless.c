@@ -0,0 +1,174 @@
+#include <SDL3/SDL.h>
+#include "types.h"
+#include "fsm.h"
+
+// Headless mode runs the simulation without a window or renderer, as fast as
+// the CPU allows. Simulated time advances by FIXED_TICK_RATE per step so that
+// tick() runs exactly one fixed step each call.
+
+#define HEADLESS_DEFAULT_TICKS  100000
+#define HEADLESS_BATCH_TICKS    1024
+#define HEADLESS_SCRIPT_PERIOD  240
+#define HEADLESS_SCRIPT_STAGGER 37
+
+typedef struct SC_Headless {
+    bool enabled;
+    Uint64 ticksTotal; // 0 runs until quit
+    Uint32 numCharacters;
+    Uint64 now;
+    Uint64 perfStart;
+    Uint64 perfReport;
+    Uint64 ticksReport;
+    Uint64 perfSlowest; // Longest single tick() call
+    Uint64 overBudget;  // tick() calls that took longer than FIXED_TICK_RATE
+} SC_Headless;
+
+SC_Headless headless = {
+    .enabled = false,
+    .ticksTotal = HEADLESS_DEFAULT_TICKS,
+    .numCharacters = 1,
+};
+
+typedef struct SC_ScriptStep {
+    Uint32 tick;
+    SC_Event event;
+    Uint64 opts;
+} SC_ScriptStep;
+
+// Every character replays this loop, offset by its index, so that the
+// characters are spread across all of the states instead of moving in step
+static const SC_ScriptStep headlessScript[] = {
+    {   0, SC_EVENT_RUN_START, CHARACTER_MOVE_RIGHT },
+    {  30, SC_EVENT_JUMP,      0 },
+    {  50, SC_EVENT_JUMP_STOP, 0 },
+    {  90, SC_EVENT_RUN_STOP,  CHARACTER_MOVE_RIGHT },
+    { 120, SC_EVENT_RUN_START, CHARACTER_MOVE_LEFT },
+    { 135, SC_EVENT_JUMP,      0 },
+    { 180, SC_EVENT_JUMP_STOP, 0 },
+    { 200, SC_EVENT_RUN_STOP,  CHARACTER_MOVE_LEFT },
+    { 220, SC_EVENT_JUMP,      0 },
+    { 225, SC_EVENT_JUMP_STOP, 0 },
+};
+
+// headlessScript index for each phase of the loop, or -1
+static Sint8 headlessScriptAt[HEADLESS_SCRIPT_PERIOD];
+
+void headlessScriptInit()
+{
+    SDL_memset(headlessScriptAt, -1, sizeof(headlessScriptAt));
+    for (Uint32 j = 0; j < SDL_arraysize(headlessScript); j++) {
+        headlessScriptAt[headlessScript[j].tick] = (Sint8) j;
+    }
+}
+
+// Drives characters from index `first` on
+void headlessScriptStep(SC_AppState *s, Uint32 first, Uint64 now)
+{
+    Uint32 phase = (s->tickCount + first * HEADLESS_SCRIPT_STAGGER) % HEADLESS_SCRIPT_PERIOD;
+
+    for (Uint32 i = first; i < s->characters.count; i++) {
+        Sint8 j = headlessScriptAt[phase];
+        if (j >= 0) {
+            eventCharacter(&s->characters, i, headlessScript[j].event, now, headlessScript[j].opts);
+        }
+
+        phase += HEADLESS_SCRIPT_STAGGER;
+        if (phase >= HEADLESS_SCRIPT_PERIOD) {
+            phase -= HEADLESS_SCRIPT_PERIOD;
+        }
+    }
+}
+
+void headlessReport(SC_AppState *s, const char *label, Uint64 ticks, Uint64 perfTicks)
+{
+    double seconds = (double) perfTicks / (double) SDL_GetPerformanceFrequency();
+    double charTicks = (double) ticks * (double) s->characters.count;
+
+    if (ticks == 0 || seconds <= 0.0) {
+        return;
+    }
+
+    SDL_Log("%s: %" SDL_PRIu64 " ticks, %u characters, %.0f ticks/s, %.2f ns/character-tick, %u active, %u sleeping",
+        label,
+        ticks,
+        s->characters.count,
+        (double) ticks / seconds,
+        seconds * 1e9 / charTicks,
+        s->characters.numActive,
+        s->characters.count - s->characters.numActive);
+}
+
+// Averages of the active and sleeping counts over every tick so far
+void headlessReportSchedule(SC_AppState *s)
+{
+    if (s->tickCount == 0) {
+        return;
+    }
+
+    SDL_Log("Characters per tick: %.1f active, %.1f sleeping",
+        (double) s->activeTicks / (double) s->tickCount,
+        (double) s->sleepingTicks / (double) s->tickCount);
+}
+
+void headlessStart(SC_AppState *s)
+{
+    headlessScriptInit();
+
+    headless.now = s->prevTick;
+    headless.perfStart = SDL_GetPerformanceCounter();
+    headless.perfReport = headless.perfStart;
+    headless.ticksReport = 0;
+    headless.perfSlowest = 0;
+    headless.overBudget = 0;
+
+    SDL_Log("Headless: running %" SDL_PRIu64 " ticks with %u characters, %u arena enemies",
+        headless.ticksTotal, s->characters.count, s->numArenaEnemies);
+}
+
+SDL_AppResult headlessIterate(SC_AppState *s)
+{
+    Uint64 budget = SDL_GetPerformanceFrequency() * FIXED_TICK_RATE / 1000;
+
+    for (int i = 0; i < HEADLESS_BATCH_TICKS; i++) {
+        if (headless.ticksTotal > 0 && s->tickCount >= headless.ticksTotal) {
+            break;
+        }
+
+        headlessScriptStep(s, 0, headless.now);
+        headless.now += FIXED_TICK_RATE;
+
+        // Each call runs one fixed step, which has to fit in the time a
+        // step stands for to keep up in real time
+        Uint64 start = SDL_GetPerformanceCounter();
+        tick(s, headless.now);
+        Uint64 elapsed = SDL_GetPerformanceCounter() - start;
+        headless.perfSlowest = SDL_max(headless.perfSlowest, elapsed);
+        if (elapsed > budget) {
+            headless.overBudget++;
+        }
+    }
+
+    Uint64 perfNow = SDL_GetPerformanceCounter();
+
+    // Report roughly once per second of wall time
+    if (perfNow - headless.perfReport >= SDL_GetPerformanceFrequency()) {
+        headlessReport(s, "Headless", s->tickCount - headless.ticksReport, perfNow - headless.perfReport);
+        headless.perfReport = perfNow;
+        headless.ticksReport = s->tickCount;
+    }
+
+    if (headless.ticksTotal > 0 && s->tickCount >= headless.ticksTotal) {
+        headlessReport(s, "Headless total", s->tickCount, perfNow - headless.perfStart);
+        headlessReportSchedule(s);
+        SDL_Log("Player contacts: %" SDL_PRIu64 " bumps, %" SDL_PRIu64 " stomps",
+            s->collisions.totalBumps, s->collisions.totalStomps);
+        SDL_Log("Enemies: %u out, %u spawned, %" SDL_PRIu64 " flipped, %" SDL_PRIu64 " kicked, %u spawns dropped",
+            s->enemies.count, s->enemies.numSpawned, s->enemies.totalFlipped, s->enemies.totalKilled, s->enemies.dropped);
+        SDL_Log("Slowest tick %.3f ms, %" SDL_PRIu64 " of %" SDL_PRIu64 " over the %d ms budget",
+            (double) headless.perfSlowest * 1e3 / (double) SDL_GetPerformanceFrequency(),
+            headless.overBudget, s->tickCount, FIXED_TICK_RATE);
+        return SDL_APP_SUCCESS;
+    }
+
+    return SDL_APP_CONTINUE;
+}
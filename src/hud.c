@@ -0,0 +1,213 @@
+#include <SDL3/SDL.h>
+
+// The HUD keeps every piece of text in its own texture and only draws it
+// again when the value behind it changes, so a frame where nothing changed
+// costs one texture copy per item. Counters are put together from a glyph
+// atlas of the digits rather than going through the debug font.
+//
+// Each frame, for every item, check whether its value changed with
+// hudChanged() and write the new text if so, then draw it all with
+// renderHud().
+
+#define HUD_TEXT_MAX   32
+#define HUD_GLYPHS     "0123456789"
+#define HUD_GLYPH_SIZE SDL_DEBUG_TEXT_FONT_CHARACTER_SIZE
+
+typedef enum SC_HudItem {
+    SC_HUD_LEFT,
+    SC_HUD_RIGHT,
+    SC_HUD_JUMP,
+    SC_HUD_STATE,
+    SC_HUD_KICKED_LABEL,
+    SC_HUD_KICKED,
+    SC_HUD_ENEMIES_LABEL,
+    SC_HUD_ENEMIES,
+    SC_HUD_TOTAL,
+} SC_HudItem;
+
+typedef struct SC_HudText {
+    float x;
+    float y;
+    float scale;
+    Uint32 digits; // Counters only, drawn zero-padded from the glyph atlas
+
+    char text[HUD_TEXT_MAX + 1];
+    Uint64 value;         // What text was written from
+    bool stale;           // text changed since the texture was drawn
+    float width;          // Of text in the texture, in px before scaling
+    SDL_Texture *texture; // HUD_TEXT_MAX glyphs wide, NULL without render targets
+} SC_HudText;
+
+typedef struct SC_Hud {
+    SC_HudText items[SC_HUD_TOTAL];
+    SDL_Texture *glyphs; // HUD_GLYPHS in a row
+    bool glyphsStale;
+    SC_RenderBatch batch; // Quads of one counter, sampling glyphs
+} SC_Hud;
+
+static const SDL_Color hudColor = { 255, 238, 229, SDL_ALPHA_OPAQUE };
+
+SC_Hud hud = {
+    .items = {
+        [SC_HUD_LEFT]          = { .x = 15.0f, .y = 15.0f,  .scale = 3.0f },
+        [SC_HUD_RIGHT]         = { .x = 15.0f, .y = 45.0f,  .scale = 3.0f },
+        [SC_HUD_JUMP]          = { .x = 15.0f, .y = 75.0f,  .scale = 3.0f },
+        [SC_HUD_STATE]         = { .x = 15.0f, .y = 105.0f, .scale = 3.0f },
+        [SC_HUD_KICKED_LABEL]  = { .x = 15.0f, .y = 690.0f, .scale = 2.0f },
+        [SC_HUD_KICKED]        = { .x = 127.0f, .y = 690.0f, .scale = 2.0f, .digits = 6 },
+        [SC_HUD_ENEMIES_LABEL] = { .x = 300.0f, .y = 690.0f, .scale = 2.0f },
+        [SC_HUD_ENEMIES]       = { .x = 428.0f, .y = 690.0f, .scale = 2.0f, .digits = 5 },
+    },
+};
+
+// Glyphs and text are drawn white, items are tinted when copied to the screen
+static SDL_Texture *createHudTexture(SDL_Renderer *renderer, int w, int h)
+{
+    SDL_Texture *t = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, w, h);
+    if (t != NULL) {
+        SDL_SetTextureBlendMode(t, SDL_BLENDMODE_BLEND);
+        SDL_SetTextureScaleMode(t, SDL_SCALEMODE_NEAREST);
+    }
+    return t;
+}
+
+// Render target contents can be lost without the textures going away
+void hudTargetsLost(SC_Hud *h)
+{
+    h->glyphsStale = true;
+    for (int i = 0; i < SC_HUD_TOTAL; i++) {
+        h->items[i].stale = true;
+    }
+}
+
+void destroyHud(SC_Hud *h)
+{
+    for (int i = 0; i < SC_HUD_TOTAL; i++) {
+        SDL_DestroyTexture(h->items[i].texture);
+        h->items[i].texture = NULL;
+    }
+    SDL_DestroyTexture(h->glyphs);
+    h->glyphs = NULL;
+    destroyRenderBatch(&h->batch);
+}
+
+// Textures are lost with the render device, so this also runs after a reset.
+// Without render target support the HUD is drawn with the debug font every
+// frame instead.
+void createHud(SC_Hud *h, SDL_Renderer *renderer)
+{
+    destroyHud(h);
+
+    h->glyphs = createHudTexture(renderer, (int) SDL_strlen(HUD_GLYPHS) * HUD_GLYPH_SIZE, HUD_GLYPH_SIZE);
+    bool ok = h->glyphs != NULL;
+    for (int i = 0; ok && i < SC_HUD_TOTAL; i++) {
+        SDL_Texture *t = createHudTexture(renderer, HUD_TEXT_MAX * HUD_GLYPH_SIZE, HUD_GLYPH_SIZE);
+        if (t == NULL) {
+            ok = false;
+            break;
+        }
+        SDL_SetTextureColorMod(t, hudColor.r, hudColor.g, hudColor.b);
+        h->items[i].texture = t;
+    }
+    if (!ok) {
+        SDL_Log("Failed to create HUD textures, drawing text every frame: %s", SDL_GetError());
+        destroyHud(h);
+        return;
+    }
+
+    h->batch.texture = h->glyphs;
+    hudTargetsLost(h);
+}
+
+// Whether `value` differs from what the item shows. If so the caller writes
+// the new text, and the item is drawn again.
+bool hudChanged(SC_HudText *t, Uint64 value)
+{
+    if (t->value == value && t->text[0] != '\0') {
+        return false;
+    }
+    t->value = value;
+    t->stale = true;
+    return true;
+}
+
+void hudCounter(SC_HudText *t, Uint64 value)
+{
+    if (hudChanged(t, value)) {
+        SDL_snprintf(t->text, sizeof(t->text), "%0*" SDL_PRIu64, (int) t->digits, value);
+    }
+}
+
+static void drawHudGlyphs(SDL_Renderer *renderer, SC_Hud *h)
+{
+    SDL_SetRenderTarget(renderer, h->glyphs);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, SDL_ALPHA_TRANSPARENT);
+    SDL_RenderClear(renderer);
+    SDL_SetRenderDrawColor(renderer, 255, 255, 255, SDL_ALPHA_OPAQUE);
+    SDL_RenderDebugText(renderer, 0.0f, 0.0f, HUD_GLYPHS);
+    h->glyphsStale = false;
+}
+
+// Digits come from the glyph atlas in one SDL_RenderGeometry call, anything
+// else from the debug font
+static void drawHudText(SDL_Renderer *renderer, SC_Hud *h, SC_HudText *t)
+{
+    SDL_SetRenderTarget(renderer, t->texture);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, SDL_ALPHA_TRANSPARENT);
+    SDL_RenderClear(renderer);
+
+    if (t->digits > 0) {
+        float glyphW = 1.0f / (float) SDL_strlen(HUD_GLYPHS);
+        for (int k = 0; t->text[k] != '\0'; k++) {
+            SDL_FRect dst = { (float) (k * HUD_GLYPH_SIZE), 0.0f, HUD_GLYPH_SIZE, HUD_GLYPH_SIZE };
+            SDL_FRect uv = { (t->text[k] - '0') * glyphW, 0.0f, glyphW, 1.0f };
+            batchSprite(&h->batch, &dst, &uv);
+        }
+        flushRenderBatch(renderer, &h->batch);
+    } else {
+        SDL_SetRenderDrawColor(renderer, 255, 255, 255, SDL_ALPHA_OPAQUE);
+        SDL_RenderDebugText(renderer, 0.0f, 0.0f, t->text);
+    }
+
+    t->width = (float) (SDL_strlen(t->text) * HUD_GLYPH_SIZE);
+    t->stale = false;
+}
+
+void renderHud(SDL_Renderer *renderer, SC_Hud *h)
+{
+    if (h->glyphs == NULL) {
+        SDL_SetRenderDrawColor(renderer, hudColor.r, hudColor.g, hudColor.b, hudColor.a);
+        for (int i = 0; i < SC_HUD_TOTAL; i++) {
+            SC_HudText *t = &h->items[i];
+            SDL_SetRenderScale(renderer, t->scale, t->scale);
+            SDL_RenderDebugText(renderer, t->x / t->scale, t->y / t->scale, t->text);
+        }
+        SDL_SetRenderScale(renderer, 1.0f, 1.0f);
+        return;
+    }
+
+    bool drawn = false;
+    if (h->glyphsStale) {
+        drawHudGlyphs(renderer, h);
+        drawn = true;
+    }
+    for (int i = 0; i < SC_HUD_TOTAL; i++) {
+        if (h->items[i].stale) {
+            drawHudText(renderer, h, &h->items[i]);
+            drawn = true;
+        }
+    }
+    if (drawn) {
+        SDL_SetRenderTarget(renderer, NULL);
+    }
+
+    for (int i = 0; i < SC_HUD_TOTAL; i++) {
+        SC_HudText *t = &h->items[i];
+        if (t->width == 0.0f) {
+            continue;
+        }
+        SDL_FRect src = { 0.0f, 0.0f, t->width, HUD_GLYPH_SIZE };
+        SDL_FRect dst = { t->x, t->y, t->width * t->scale, HUD_GLYPH_SIZE * t->scale };
+        SDL_RenderTexture(renderer, t->texture, &src, &dst);
+    }
+}
@@ -0,0 +1,58 @@
+#include <SDL3/SDL.h>
+#include "types.h"
+
+// Key presses are queued with the time SDL saw them rather than applied as
+// soon as SDL_AppEvent runs. tick() pops each one right before the fixed
+// step whose time span it falls in, so a press always lands on the same
+// tick however the frame and the accumulator line up.
+
+void initInputQueue(SC_InputQueue *q)
+{
+    SDL_SetAtomicU32(&q->head, 0);
+    SDL_SetAtomicU32(&q->tail, 0);
+    q->dropped = 0;
+}
+
+// Producer side. Returns false, dropping the event, if the queue is full.
+bool pushInput(SC_InputQueue *q, Uint64 timestamp, Uint32 event, Uint32 keyFlag)
+{
+    Uint32 tail = SDL_GetAtomicU32(&q->tail);
+    Uint32 head = SDL_GetAtomicU32(&q->head);
+
+    if (tail - head >= SC_INPUT_QUEUE_SIZE) {
+        q->dropped++;
+        return false;
+    }
+
+    q->events[tail & (SC_INPUT_QUEUE_SIZE - 1)] = (SC_InputEvent) {
+        .timestamp = timestamp,
+        .event = event,
+        .keyFlag = keyFlag,
+    };
+
+    // Publishes the event, SDL's atomics are full barriers
+    SDL_SetAtomicU32(&q->tail, tail + 1);
+    return true;
+}
+
+// Consumer side. Pops the oldest event if it happened at or before `until`
+// (ns). Events are pushed in the order they happened, so the first one that
+// is too new stops the drain.
+bool popInputUntil(SC_InputQueue *q, Uint64 until, SC_InputEvent *out)
+{
+    Uint32 head = SDL_GetAtomicU32(&q->head);
+    Uint32 tail = SDL_GetAtomicU32(&q->tail);
+
+    if (head == tail) {
+        return false;
+    }
+
+    const SC_InputEvent *e = &q->events[head & (SC_INPUT_QUEUE_SIZE - 1)];
+    if (e->timestamp > until) {
+        return false;
+    }
+
+    *out = *e;
+    SDL_SetAtomicU32(&q->head, head + 1);
+    return true;
+}
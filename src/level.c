@@ -0,0 +1,677 @@
+#include <SDL3/SDL.h>
+#include "types.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Levels are written as text and compiled (--compile-level) into a binary
+// file that is mapped into memory and used where it lies. Everything the
+// simulation needs, including the collision grid filing, is worked out by
+// the compiler, so loading a level only checks that the file is sane and
+// points SC_Level at its sections. Switching levels costs a mapping, not a
+// parse.
+//
+// File layout, native byte order (only little endian hosts load levels),
+// every section 4-byte aligned:
+//   SC_LevelHeader
+//   platforms      SC_Platform[numPlatforms]
+//   spawns         SC_SpawnPoint[numSpawns]
+//   pipes          SC_Pipe[numPipes]
+//   schedule       SC_PipeSpawn[numScheduled], ordered by tick
+//   cellStart      Uint32[SC_GRID_CELLS + 1]
+//   cellPlatforms  Uint16[numFiled]
+//   nextRow        Uint8[SC_GRID_CELLS]
+//
+// Text format, one item per line, # starts a comment:
+//   ground Y
+//   spawn X Y
+//   platform LEFT RIGHT TOP
+//   pipe X Y left|right
+//   enemy TICK PIPE KIND       spawn schedule, PIPE counts pipes from 0
+
+#define SC_LEVEL_MAGIC   0x564C4353 // "SCLV"
+#define SC_LEVEL_VERSION 1
+
+// Coordinates have to fit Q16.16 for fixed point builds
+#define SC_LEVEL_COORD_MAX 32767
+
+#define SC_LEVEL_LINE_MAX 256
+
+typedef struct SC_LevelHeader {
+    Uint32 magic;
+    Uint32 version;
+    Uint32 size; // Of the whole file
+    Uint32 gridCellSize; // The grid has to match the build's
+    Uint32 gridCols;
+    Uint32 gridRows;
+    Sint32 groundY;
+    Uint32 numPlatforms;
+    Uint32 numFiled;
+    Uint32 numSpawns;
+    Uint32 numPipes;
+    Uint32 numScheduled;
+
+    // Section offsets from the start of the file
+    Uint32 platforms;
+    Uint32 spawns;
+    Uint32 pipes;
+    Uint32 schedule;
+    Uint32 cellStart;
+    Uint32 cellPlatforms;
+    Uint32 nextRow;
+} SC_LevelHeader;
+
+// Platforms sit on the old guide lines 40px apart. Platforms on neighbouring
+// lines don't overlap, so standing on one never puts a character's head
+// through the next, and every platform can be walked off to get back down.
+static const char defaultLevelText[] =
+    "ground 600\n"
+    "spawn 200 600\n"
+    "platform 0 240 560\n"
+    "platform 720 960 560\n"
+    "platform 300 660 520\n"
+    "platform 0 240 480\n"
+    "platform 720 960 480\n"
+    "platform 300 660 440\n"
+    "pipe 40 120 right\n"
+    "pipe 920 120 left\n"
+    "enemy 120 0 0\n"
+    "enemy 240 1 0\n";
+
+// Positions off the playfield count as the nearest edge cell
+static int gridCol(SC_Real x)
+{
+    int col = REAL_TO_INT(x) / SC_GRID_CELL_SIZE;
+    return SDL_clamp(col, 0, SC_GRID_COLS - 1);
+}
+
+static int gridRow(SC_Real y)
+{
+    int row = REAL_TO_INT(y) / SC_GRID_CELL_SIZE;
+    return SDL_clamp(row, 0, SC_GRID_ROWS - 1);
+}
+
+static bool levelSectionFits(const SC_LevelHeader *h, Uint32 offset, Uint64 count, size_t itemSize)
+{
+    return offset % 4 == 0 && offset >= sizeof(SC_LevelHeader) && offset <= h->size
+        && count * itemSize <= h->size - offset;
+}
+
+static bool levelCoordFits(Sint32 v)
+{
+    return v >= -SC_LEVEL_COORD_MAX && v <= SC_LEVEL_COORD_MAX;
+}
+
+// Points `l` at the sections of a compiled level in `data`. Only checks what
+// has to hold for computeFloors and friends to stay inside the arrays, which
+// is one pass over the grid and the small sections.
+static bool attachLevel(SC_Level *l, void *data, size_t size, bool mapped, const char *name)
+{
+    const SC_LevelHeader *h = data;
+
+    if (SDL_BYTEORDER != SDL_LIL_ENDIAN) {
+        SDL_Log("%s: levels only load on little endian machines", name);
+        return false;
+    }
+    if (size < sizeof(SC_LevelHeader) || h->magic != SC_LEVEL_MAGIC || h->version != SC_LEVEL_VERSION) {
+        SDL_Log("%s is not a version %d level", name, SC_LEVEL_VERSION);
+        return false;
+    }
+    if (h->size != size || h->gridCellSize != SC_GRID_CELL_SIZE || h->gridCols != SC_GRID_COLS || h->gridRows != SC_GRID_ROWS) {
+        SDL_Log("%s: truncated, or compiled for a different grid", name);
+        return false;
+    }
+    if (!levelSectionFits(h, h->platforms, h->numPlatforms, sizeof(SC_Platform))
+        || !levelSectionFits(h, h->spawns, h->numSpawns, sizeof(SC_SpawnPoint))
+        || !levelSectionFits(h, h->pipes, h->numPipes, sizeof(SC_Pipe))
+        || !levelSectionFits(h, h->schedule, h->numScheduled, sizeof(SC_PipeSpawn))
+        || !levelSectionFits(h, h->cellStart, SC_GRID_CELLS + 1, sizeof(Uint32))
+        || !levelSectionFits(h, h->cellPlatforms, h->numFiled, sizeof(Uint16))
+        || !levelSectionFits(h, h->nextRow, SC_GRID_CELLS, sizeof(Uint8))
+        || h->numSpawns == 0 || !levelCoordFits(h->groundY)) {
+        SDL_Log("%s: bad section table", name);
+        return false;
+    }
+
+    const Uint8 *base = data;
+    const Uint32 *cellStart = (const Uint32 *) (base + h->cellStart);
+    const Uint16 *cellPlatforms = (const Uint16 *) (base + h->cellPlatforms);
+    const Uint8 *nextRow = base + h->nextRow;
+    const SC_PipeSpawn *schedule = (const SC_PipeSpawn *) (base + h->schedule);
+
+    for (int k = 0; k < SC_GRID_CELLS; k++) {
+        // A nextRow above the cell would send computeFloors round in circles
+        if (cellStart[k] > cellStart[k + 1] || nextRow[k] < k / SC_GRID_COLS || nextRow[k] > SC_GRID_ROWS) {
+            SDL_Log("%s: bad grid", name);
+            return false;
+        }
+    }
+    if (cellStart[0] != 0 || cellStart[SC_GRID_CELLS] != h->numFiled) {
+        SDL_Log("%s: bad grid", name);
+        return false;
+    }
+    for (Uint32 n = 0; n < h->numFiled; n++) {
+        if (cellPlatforms[n] >= h->numPlatforms) {
+            SDL_Log("%s: bad grid", name);
+            return false;
+        }
+    }
+    for (Uint32 n = 0; n < h->numScheduled; n++) {
+        if (schedule[n].pipe >= h->numPipes) {
+            SDL_Log("%s: enemy scheduled from a missing pipe", name);
+            return false;
+        }
+    }
+
+    SDL_zerop(l);
+    l->platforms = (const SC_Platform *) (base + h->platforms);
+    l->cellPlatforms = cellPlatforms;
+    l->cellStart = cellStart;
+    l->nextRow = nextRow;
+    l->spawns = (const SC_SpawnPoint *) (base + h->spawns);
+    l->pipes = (const SC_Pipe *) (base + h->pipes);
+    l->schedule = schedule;
+    l->numPlatforms = h->numPlatforms;
+    l->numSpawns = h->numSpawns;
+    l->numPipes = h->numPipes;
+    l->numScheduled = h->numScheduled;
+    l->groundY = REAL_FROM_INT(h->groundY);
+    l->checksum = SDL_crc32(0, data, size);
+    l->data = data;
+    l->size = size;
+    l->mapped = mapped;
+    return true;
+}
+
+static void releaseLevelData(void *data, size_t size, bool mapped)
+{
+#ifndef _WIN32
+    if (mapped) {
+        munmap(data, size);
+        return;
+    }
+#endif
+    SDL_free(data);
+}
+
+void destroyLevel(SC_Level *l)
+{
+    if (l->data != NULL) {
+        releaseLevelData(l->data, l->size, l->mapped);
+    }
+    SDL_zerop(l);
+}
+
+// Maps a compiled level file. On failure `l` is left untouched, so a level
+// that fails to load doesn't take the current one down with it.
+bool loadLevel(SC_Level *l, const char *path)
+{
+    void *data = NULL;
+    size_t size = 0;
+    bool mapped = false;
+
+#ifndef _WIN32
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        SDL_Log("Failed to open %s", path);
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        size = (size_t) st.st_size;
+        data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            data = NULL;
+        }
+    }
+    close(fd);
+    mapped = true;
+#else
+    data = SDL_LoadFile(path, &size);
+#endif
+
+    if (data == NULL) {
+        SDL_Log("Failed to load %s", path);
+        return false;
+    }
+
+    SC_Level loaded;
+    if (!attachLevel(&loaded, data, size, mapped, path)) {
+        releaseLevelData(data, size, mapped);
+        return false;
+    }
+
+    destroyLevel(l);
+    *l = loaded;
+    return true;
+}
+
+typedef struct SC_LevelSource {
+    Sint32 groundY;
+    SC_Platform *platforms;
+    SC_SpawnPoint *spawns;
+    SC_Pipe *pipes;
+    SC_PipeSpawn *schedule;
+    Uint32 numPlatforms;
+    Uint32 numSpawns;
+    Uint32 numPipes;
+    Uint32 numScheduled;
+    Uint32 capacity; // Of each array, they grow together
+} SC_LevelSource;
+
+static void destroyLevelSource(SC_LevelSource *src)
+{
+    SDL_free(src->platforms);
+    SDL_free(src->spawns);
+    SDL_free(src->pipes);
+    SDL_free(src->schedule);
+    SDL_zerop(src);
+}
+
+static bool growLevelSource(SC_LevelSource *src)
+{
+    Uint32 capacity = src->capacity > 0 ? src->capacity * 2 : 16;
+
+    SC_Platform *platforms = SDL_realloc(src->platforms, capacity * sizeof(SC_Platform));
+    if (platforms != NULL) {
+        src->platforms = platforms;
+    }
+    SC_SpawnPoint *spawns = SDL_realloc(src->spawns, capacity * sizeof(SC_SpawnPoint));
+    if (spawns != NULL) {
+        src->spawns = spawns;
+    }
+    SC_Pipe *pipes = SDL_realloc(src->pipes, capacity * sizeof(SC_Pipe));
+    if (pipes != NULL) {
+        src->pipes = pipes;
+    }
+    SC_PipeSpawn *schedule = SDL_realloc(src->schedule, capacity * sizeof(SC_PipeSpawn));
+    if (schedule != NULL) {
+        src->schedule = schedule;
+    }
+
+    if (platforms == NULL || spawns == NULL || pipes == NULL || schedule == NULL) {
+        return false;
+    }
+    src->capacity = capacity;
+    return true;
+}
+
+// Reads one line of level text into `src`. Returns false with a message in
+// `error` if it doesn't make sense.
+static bool parseLevelLine(SC_LevelSource *src, char *line, const char **error)
+{
+    char *comment = SDL_strchr(line, '#');
+    if (comment != NULL) {
+        *comment = '\0';
+    }
+
+    char word[16];
+    if (SDL_sscanf(line, "%15s", word) != 1) {
+        return true;
+    }
+
+    Uint32 most = SDL_max(SDL_max(src->numPlatforms, src->numSpawns), SDL_max(src->numPipes, src->numScheduled));
+    if (most == src->capacity && !growLevelSource(src)) {
+        *error = "out of memory";
+        return false;
+    }
+
+    int a, b, c;
+    char extra;
+    if (SDL_strcmp(word, "ground") == 0) {
+        if (SDL_sscanf(line, " ground %d %c", &a, &extra) != 1 || !levelCoordFits(a)) {
+            *error = "expected: ground Y";
+            return false;
+        }
+        src->groundY = a;
+    } else if (SDL_strcmp(word, "spawn") == 0) {
+        if (SDL_sscanf(line, " spawn %d %d %c", &a, &b, &extra) != 2 || !levelCoordFits(a) || !levelCoordFits(b)) {
+            *error = "expected: spawn X Y";
+            return false;
+        }
+        src->spawns[src->numSpawns++] = (SC_SpawnPoint) { a, b };
+    } else if (SDL_strcmp(word, "platform") == 0) {
+        if (SDL_sscanf(line, " platform %d %d %d %c", &a, &b, &c, &extra) != 3
+            || a > b || !levelCoordFits(a) || !levelCoordFits(b) || !levelCoordFits(c)) {
+            *error = "expected: platform LEFT RIGHT TOP";
+            return false;
+        }
+        if (src->numPlatforms == SDL_MAX_UINT16) {
+            *error = "too many platforms";
+            return false;
+        }
+        src->platforms[src->numPlatforms++] = (SC_Platform) { a, b, c };
+    } else if (SDL_strcmp(word, "pipe") == 0) {
+        char dir[8];
+        if (SDL_sscanf(line, " pipe %d %d %7s %c", &a, &b, dir, &extra) != 3
+            || (SDL_strcmp(dir, "left") != 0 && SDL_strcmp(dir, "right") != 0)
+            || !levelCoordFits(a) || !levelCoordFits(b)) {
+            *error = "expected: pipe X Y left|right";
+            return false;
+        }
+        src->pipes[src->numPipes++] = (SC_Pipe) { a, b, SDL_strcmp(dir, "right") == 0 ? 1 : -1 };
+    } else if (SDL_strcmp(word, "enemy") == 0) {
+        if (SDL_sscanf(line, " enemy %d %d %d %c", &a, &b, &c, &extra) != 3
+            || a < 0 || b < 0 || b > SDL_MAX_UINT16 || c < 0 || c > SDL_MAX_UINT16) {
+            *error = "expected: enemy TICK PIPE KIND";
+            return false;
+        }
+        src->schedule[src->numScheduled++] = (SC_PipeSpawn) { (Uint32) a, (Uint16) b, (Uint16) c };
+    } else {
+        *error = "unknown item";
+        return false;
+    }
+
+    return true;
+}
+
+// Orders the schedule by tick. Insertion sort keeps the text order for
+// enemies due on the same tick, and schedules are short and usually written
+// in order already.
+static void sortSchedule(SC_PipeSpawn *schedule, Uint32 n)
+{
+    for (Uint32 i = 1; i < n; i++) {
+        SC_PipeSpawn item = schedule[i];
+        Uint32 j = i;
+        while (j > 0 && schedule[j - 1].tick > item.tick) {
+            schedule[j] = schedule[j - 1];
+            j--;
+        }
+        schedule[j] = item;
+    }
+}
+
+static Uint32 alignLevelOffset(Uint32 offset)
+{
+    return (offset + 3) & ~3u;
+}
+
+// Lays out a compiled level. The returned buffer is SDL_malloc'd.
+static void *buildLevel(SC_LevelSource *src, size_t *size)
+{
+    SC_LevelHeader h = {
+        .magic = SC_LEVEL_MAGIC,
+        .version = SC_LEVEL_VERSION,
+        .gridCellSize = SC_GRID_CELL_SIZE,
+        .gridCols = SC_GRID_COLS,
+        .gridRows = SC_GRID_ROWS,
+        .groundY = src->groundY,
+        .numPlatforms = src->numPlatforms,
+        .numSpawns = src->numSpawns,
+        .numPipes = src->numPipes,
+        .numScheduled = src->numScheduled,
+    };
+
+    sortSchedule(src->schedule, src->numScheduled);
+
+    Uint32 counts[SC_GRID_CELLS] = { 0 };
+    for (Uint32 p = 0; p < src->numPlatforms; p++) {
+        const SC_Platform *platform = &src->platforms[p];
+        int row = gridRow(REAL_FROM_INT(platform->top));
+        for (int col = gridCol(REAL_FROM_INT(platform->left)); col <= gridCol(REAL_FROM_INT(platform->right)); col++) {
+            counts[row * SC_GRID_COLS + col]++;
+            h.numFiled++;
+        }
+    }
+
+    h.platforms = sizeof(SC_LevelHeader);
+    h.spawns = h.platforms + h.numPlatforms * sizeof(SC_Platform);
+    h.pipes = h.spawns + h.numSpawns * sizeof(SC_SpawnPoint);
+    h.schedule = h.pipes + h.numPipes * sizeof(SC_Pipe);
+    h.cellStart = h.schedule + h.numScheduled * sizeof(SC_PipeSpawn);
+    h.cellPlatforms = h.cellStart + (SC_GRID_CELLS + 1) * sizeof(Uint32);
+    h.nextRow = alignLevelOffset(h.cellPlatforms + h.numFiled * sizeof(Uint16));
+    h.size = alignLevelOffset(h.nextRow + SC_GRID_CELLS);
+
+    Uint8 *data = SDL_calloc(1, h.size);
+    if (data == NULL) {
+        return NULL;
+    }
+
+    SDL_memcpy(data, &h, sizeof(h));
+    SDL_memcpy(data + h.platforms, src->platforms, h.numPlatforms * sizeof(SC_Platform));
+    SDL_memcpy(data + h.spawns, src->spawns, h.numSpawns * sizeof(SC_SpawnPoint));
+    SDL_memcpy(data + h.pipes, src->pipes, h.numPipes * sizeof(SC_Pipe));
+    SDL_memcpy(data + h.schedule, src->schedule, h.numScheduled * sizeof(SC_PipeSpawn));
+
+    Uint32 *cellStart = (Uint32 *) (data + h.cellStart);
+    Uint16 *cellPlatforms = (Uint16 *) (data + h.cellPlatforms);
+    Uint8 *nextRow = data + h.nextRow;
+
+    Uint32 start = 0;
+    for (int k = 0; k < SC_GRID_CELLS; k++) {
+        cellStart[k] = start;
+        start += counts[k];
+    }
+    cellStart[SC_GRID_CELLS] = start;
+
+    Uint32 next[SC_GRID_CELLS];
+    SDL_memcpy(next, cellStart, sizeof(next));
+    for (Uint32 p = 0; p < src->numPlatforms; p++) {
+        const SC_Platform *platform = &src->platforms[p];
+        int row = gridRow(REAL_FROM_INT(platform->top));
+        for (int col = gridCol(REAL_FROM_INT(platform->left)); col <= gridCol(REAL_FROM_INT(platform->right)); col++) {
+            cellPlatforms[next[row * SC_GRID_COLS + col]++] = (Uint16) p;
+        }
+    }
+
+    for (int col = 0; col < SC_GRID_COLS; col++) {
+        Uint8 below = SC_GRID_ROWS;
+        for (int row = SC_GRID_ROWS - 1; row >= 0; row--) {
+            int k = row * SC_GRID_COLS + col;
+            if (counts[k] > 0) {
+                below = (Uint8) row;
+            }
+            nextRow[k] = below;
+        }
+    }
+
+    *size = h.size;
+    return data;
+}
+
+// Compiles level text into the binary format. `name` is only for messages.
+// The returned buffer is SDL_malloc'd.
+void *compileLevel(const char *text, size_t length, const char *name, size_t *size)
+{
+    SC_LevelSource src = { 0 };
+    char line[SC_LEVEL_LINE_MAX];
+    int lineNumber = 0;
+    size_t pos = 0;
+
+    while (pos < length) {
+        size_t end = pos;
+        while (end < length && text[end] != '\n') {
+            end++;
+        }
+        lineNumber++;
+
+        size_t n = end - pos;
+        if (n >= sizeof(line)) {
+            SDL_Log("%s:%d: line too long", name, lineNumber);
+            destroyLevelSource(&src);
+            return NULL;
+        }
+        SDL_memcpy(line, text + pos, n);
+        line[n] = '\0';
+        pos = end + 1;
+
+        const char *error = NULL;
+        if (!parseLevelLine(&src, line, &error)) {
+            SDL_Log("%s:%d: %s", name, lineNumber, error);
+            destroyLevelSource(&src);
+            return NULL;
+        }
+    }
+
+    if (src.numSpawns == 0) {
+        SDL_Log("%s: needs at least one spawn", name);
+        destroyLevelSource(&src);
+        return NULL;
+    }
+    for (Uint32 n = 0; n < src.numScheduled; n++) {
+        if (src.schedule[n].pipe >= src.numPipes) {
+            SDL_Log("%s: enemy scheduled from pipe %u, there are only %u", name, src.schedule[n].pipe, src.numPipes);
+            destroyLevelSource(&src);
+            return NULL;
+        }
+    }
+
+    void *data = buildLevel(&src, size);
+    if (data == NULL) {
+        SDL_Log("%s: out of memory", name);
+    }
+    destroyLevelSource(&src);
+    return data;
+}
+
+// --compile-level
+bool compileLevelFile(const char *textPath, const char *outPath)
+{
+    size_t length;
+    char *text = SDL_LoadFile(textPath, &length);
+    if (text == NULL) {
+        SDL_Log("Failed to load %s: %s", textPath, SDL_GetError());
+        return false;
+    }
+
+    size_t size;
+    void *data = compileLevel(text, length, textPath, &size);
+    SDL_free(text);
+    if (data == NULL) {
+        return false;
+    }
+
+    bool ok = SDL_SaveFile(outPath, data, size);
+    if (!ok) {
+        SDL_Log("Failed to write %s: %s", outPath, SDL_GetError());
+    } else {
+        SDL_Log("Compiled %s into %s, %u bytes", textPath, outPath, (Uint32) size);
+    }
+    SDL_free(data);
+    return ok;
+}
+
+// The level used when none is given, compiled at startup
+bool initDefaultLevel(SC_Level *l)
+{
+    size_t size;
+    void *data = compileLevel(defaultLevelText, sizeof(defaultLevelText) - 1, "default level", &size);
+    if (data == NULL) {
+        return false;
+    }
+
+    if (!attachLevel(l, data, size, false, "default level")) {
+        SDL_free(data);
+        return false;
+    }
+    return true;
+}
+
+// Sets floorY to the top of the highest platform at or below each
+// character's feet, or the ground. Falling states land when they reach it
+// and grounded states fall when they're above it. Only cells under the
+// character that hold platforms are searched, and tops in a lower row are
+// always further down, so the first row with a platform under the character
+// holds the answer. Works on anything halfWidth either side of posX and
+// standing on posY.
+static void findFloors(const SC_Level *l, const SC_Real *posX, const SC_Real *posY, SC_Real halfWidth,
+    SC_Real *floorYs, Uint32 begin, Uint32 end)
+{
+    for (Uint32 i = begin; i < end; i++) {
+        SC_Real x = posX[i];
+        SC_Real y = posY[i];
+        SC_Real floorY = l->groundY;
+        int rowFeet = gridRow(y);
+        int rowEnd = SC_GRID_ROWS;
+
+        for (int col = gridCol(x - halfWidth); col <= gridCol(x + halfWidth); col++) {
+            int row = l->nextRow[rowFeet * SC_GRID_COLS + col];
+
+            while (row < rowEnd) {
+                int k = row * SC_GRID_COLS + col;
+                for (Uint32 n = l->cellStart[k]; n < l->cellStart[k + 1]; n++) {
+                    const SC_Platform *p = &l->platforms[l->cellPlatforms[n]];
+                    SC_Real top = REAL_FROM_INT(p->top);
+                    if (top >= y && top < floorY
+                        && REAL_FROM_INT(p->left) < x + halfWidth
+                        && REAL_FROM_INT(p->right) > x - halfWidth) {
+                        floorY = top;
+                        rowEnd = row + 1;
+                    }
+                }
+
+                row = row + 1 < SC_GRID_ROWS ? l->nextRow[k + SC_GRID_COLS] : SC_GRID_ROWS;
+            }
+        }
+
+        floorYs[i] = floorY;
+    }
+}
+
+void computeFloors(SC_Characters *c, const SC_Level *l, Uint32 begin, Uint32 end)
+{
+    findFloors(l, c->posX, c->posY, CHARACTER_HALF_WIDTH, c->floorY, begin, end);
+}
+
+// The stretch of x a character standing at height `y` can move along
+// without losing its footing: every position in (*left, *right) overlaps a
+// platform with its top at `y`, the way findFloors tests overlap. Returns
+// false if the character at `x` isn't on a platform at `y`. Goes over every
+// platform rather than the grid, predicted dispatch only asks when a
+// character starts a new motion.
+bool findSupport(const SC_Level *l, SC_Real x, SC_Real y, SC_Real halfWidth, SC_Real *left, SC_Real *right)
+{
+    bool found = false;
+    bool grown = true;
+
+    // Platforms that overlap the stretch so far extend it, until none do
+    while (grown) {
+        grown = false;
+        for (Uint32 n = 0; n < l->numPlatforms; n++) {
+            const SC_Platform *p = &l->platforms[n];
+            SC_Real from = REAL_FROM_INT(p->left) - halfWidth;
+            SC_Real to = REAL_FROM_INT(p->right) + halfWidth;
+            if (REAL_FROM_INT(p->top) != y) {
+                continue;
+            }
+
+            if (!found && from < x && to > x) {
+                *left = from;
+                *right = to;
+                found = true;
+                grown = true;
+            } else if (found && from < *right && to > *left && (from < *left || to > *right)) {
+                *left = SDL_min(*left, from);
+                *right = SDL_max(*right, to);
+                grown = true;
+            }
+        }
+    }
+
+    return found;
+}
+
+// The highest floor findFloors could give a character anywhere from `xMin`
+// to `xMax` with its feet no higher than `y`
+SC_Real findFloorBound(const SC_Level *l, SC_Real xMin, SC_Real xMax, SC_Real y, SC_Real halfWidth)
+{
+    SC_Real floorY = l->groundY;
+
+    for (Uint32 n = 0; n < l->numPlatforms; n++) {
+        const SC_Platform *p = &l->platforms[n];
+        SC_Real top = REAL_FROM_INT(p->top);
+        if (top >= y && top < floorY
+            && REAL_FROM_INT(p->left) < xMax + halfWidth
+            && REAL_FROM_INT(p->right) > xMin - halfWidth) {
+            floorY = top;
+        }
+    }
+
+    return floorY;
+}
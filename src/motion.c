@@ -0,0 +1,324 @@
+#include <SDL3/SDL.h>
+#include "types.h"
+#include "fsm.h"
+
+// Predicted dispatch: skips floor and FSM checks that can't change
+// anything. Between transitions a character moves with constant
+// acceleration, clamped to the tuning's top speeds, so its speed and
+// position any number of ticks ahead have a closed form. Whenever a
+// character starts a new motion, that's used to work out the first tick its
+// state's tick conditions could be met: the peak of a jump, landing,
+// reaching top speed, coming to a stop or walking off the end of a
+// platform. Floors and the state's tick are skipped until then.
+//
+// Positions aren't evaluated from the closed form, characters are still
+// integrated every tick. In float the closed form rounds differently from
+// stepping, so evaluating it would no longer match the other dispatch modes
+// and their replays. The collision grid also refiles every character each
+// tick. So a prediction only has to never be late. In fixed point the
+// closed form is exact. In float, predictions are taken a tick early and
+// against bounds moved a little closer.
+
+// Most ticks a character goes without being checked, which is also how far
+// ahead landing looks for floors
+#define MOTION_HORIZON 64
+
+#ifdef SC_FIXED_POINT
+#define MOTION_MARGIN_TICKS 0
+#define MOTION_MARGIN       0
+typedef Sint64 SC_MotionReal; // Sums over the horizon don't fit in SC_Real
+#else
+// Stepping drifts less than 0.01 px from the closed form over the horizon
+#define MOTION_MARGIN_TICKS 1
+#define MOTION_MARGIN       0.0625
+typedef double SC_MotionReal;
+#endif
+
+// One axis of a motion, stepped the way integrateCharacters does:
+// vel = clamp(vel + dv, -max, max), then pos += delta * vel
+typedef struct SC_MotionAxis {
+    SC_MotionReal pos;
+    SC_MotionReal vel;
+    SC_MotionReal dv; // delta * acc
+    SC_MotionReal max;
+    SC_MotionReal delta;
+    SC_MotionReal free; // Ticks before the clamp holds vel, up to the horizon
+} SC_MotionAxis;
+
+typedef struct SC_Motion {
+    const SC_Characters *c;
+    Uint32 i;
+    const SC_Level *level;
+    SC_MotionAxis x;
+    SC_MotionAxis y;
+} SC_Motion;
+
+// The same motion the other way round, so that searches only have to
+// handle speeding up in one direction
+static SC_MotionAxis motionMirror(const SC_MotionAxis *a)
+{
+    SC_MotionAxis m = *a;
+    m.pos = -a->pos;
+    m.vel = -a->vel;
+    m.dv = -a->dv;
+    return m;
+}
+
+// Ticks until vel gets to `t`, for dv > 0 and vel < t. Can be any distance
+// past the horizon.
+static SC_MotionReal motionTicksUntil(const SC_MotionAxis *a, SC_MotionReal t)
+{
+#ifdef SC_FIXED_POINT
+    return (t - a->vel + a->dv - 1) / a->dv;
+#else
+    return SDL_ceil((t - a->vel) / a->dv);
+#endif
+}
+
+static SC_MotionAxis motionAxis(SC_Real pos, SC_Real vel, SC_Real acc, SC_Real max, Uint32 delta)
+{
+    SC_MotionAxis a = {
+        .pos = pos,
+        .vel = vel,
+        .dv = (SC_MotionReal) delta * acc,
+        .max = max,
+        .delta = delta,
+        .free = MOTION_HORIZON,
+    };
+
+    SC_MotionAxis up = a.dv >= 0 ? a : motionMirror(&a);
+    if (up.dv > 0) {
+        a.free = up.vel >= up.max ? 0 : SDL_min(motionTicksUntil(&up, up.max) - 1, a.free);
+    }
+    return a;
+}
+
+// vel after each of the next n ticks, summed, for n up to the horizon. vel
+// has to start within [-max, max], then it only ever changes one way.
+static SC_MotionReal motionVelSum(const SC_MotionAxis *a, Uint32 n)
+{
+    SC_MotionReal k = SDL_min(a->free, (SC_MotionReal) n);
+    SC_MotionReal held = a->dv > 0 ? a->max : -a->max;
+    return k * a->vel + a->dv * (k * (k + 1) / 2) + (n - k) * held;
+}
+
+static SC_MotionReal motionPos(const SC_MotionAxis *a, Uint32 n)
+{
+    return a->pos + a->delta * motionVelSum(a, n);
+}
+
+// First of the next `horizon` ticks that ends with vel at least `t`, for a
+// `t` within [-max, max]
+static Uint32 motionWhenVel(const SC_MotionAxis *a, SC_MotionReal t, Uint32 horizon)
+{
+    if (a->vel >= t) {
+        return 1;
+    }
+    if (a->dv <= 0) {
+        return horizon;
+    }
+    return (Uint32) SDL_min(motionTicksUntil(a, t), (SC_MotionReal) horizon);
+}
+
+// First tick in [from, to] that ends with pos at least `limit`, or to + 1.
+// vel only changes one way, so pos rises over a single stretch of ticks:
+// from where vel turns positive on when speeding up, up to it when slowing
+// down. That stretch gets a binary search.
+static Uint32 motionPosReaches(const SC_MotionAxis *a, Uint32 from, Uint32 to, SC_MotionReal limit)
+{
+    if (motionPos(a, from) >= limit) {
+        return from;
+    }
+
+    Uint32 lo = from;
+    Uint32 hi = to;
+    if (a->dv > 0 && a->vel < 0) {
+        SC_MotionReal turn = motionTicksUntil(a, 0) - 1;
+        lo = (Uint32) SDL_min(SDL_max(turn, (SC_MotionReal) from), (SC_MotionReal) to + 1);
+    } else if (a->dv < 0) {
+        SC_MotionAxis m = motionMirror(a);
+        SC_MotionReal turn = m.vel >= 0 ? 0 : motionTicksUntil(&m, 0) - 1;
+        hi = (Uint32) SDL_min(turn, (SC_MotionReal) to);
+    } else if (a->dv == 0 && a->vel <= 0) {
+        return to + 1;
+    }
+
+    if (lo > hi || motionPos(a, hi) < limit) {
+        return to + 1;
+    }
+    while (lo < hi) {
+        Uint32 mid = lo + (hi - lo) / 2;
+        if (motionPos(a, mid) >= limit) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return lo;
+}
+
+// Lowest and highest pos over ticks [0, to]: the ends, or where vel turns
+static void motionPosRange(const SC_MotionAxis *a, Uint32 to, SC_MotionReal *min, SC_MotionReal *max)
+{
+    SC_MotionReal last = motionPos(a, to);
+    *min = SDL_min(a->pos, last);
+    *max = SDL_max(a->pos, last);
+
+    SC_MotionAxis up = a->dv >= 0 ? *a : motionMirror(a);
+    if (up.dv > 0 && up.vel < 0) {
+        SC_MotionReal turn = motionTicksUntil(&up, 0) - 1;
+        if (turn < to) {
+            SC_MotionReal p = motionPos(a, (Uint32) turn);
+            *min = SDL_min(*min, p);
+            *max = SDL_max(*max, p);
+        }
+    }
+}
+
+// When each of the tick conditions in fsm-character.c can first be met,
+// within `horizon` ticks. Ticks integrate first, then check.
+
+static Uint32 characterWhenAtMax(const SC_Motion *m, Uint32 horizon)
+{
+    SC_MotionAxis left = motionMirror(&m->x);
+    Uint32 right = motionWhenVel(&m->x, m->x.max, horizon);
+    return SDL_min(right, motionWhenVel(&left, left.max, horizon));
+}
+
+static Uint32 characterWhenStopped(const SC_Motion *m, Uint32 horizon)
+{
+    if (m->c->accX[m->i] > 0) {
+        return motionWhenVel(&m->x, 0, horizon);
+    }
+    SC_MotionAxis left = motionMirror(&m->x);
+    return motionWhenVel(&left, 0, horizon);
+}
+
+static Uint32 characterWhenPeak(const SC_Motion *m, Uint32 horizon)
+{
+    return motionWhenVel(&m->y, 0, horizon);
+}
+
+// Only ground states check this, and they don't move vertically. The floor
+// changes once the character's box stops overlapping every platform at its
+// height. It's found from where the character was before integrating, so
+// that shows one tick later.
+static Uint32 characterWhenOffFloor(const SC_Motion *m, Uint32 horizon)
+{
+    const SC_Level *l = m->level;
+    SC_Real x = m->c->posX[m->i];
+    SC_Real y = m->c->posY[m->i];
+    SC_Real left;
+    SC_Real right;
+
+    if (m->y.vel != 0 || m->y.dv != 0) {
+        return 1;
+    }
+    // Nothing at or below the ground is ever off the floor
+    if (y >= l->groundY) {
+        return horizon;
+    }
+    if (!findSupport(l, x, y, CHARACTER_HALF_WIDTH, &left, &right)) {
+        return 1;
+    }
+
+    SC_MotionAxis back = motionMirror(&m->x);
+    Uint32 last = horizon - 1;
+    Uint32 offRight = motionPosReaches(&m->x, 0, last, right - MOTION_MARGIN);
+    Uint32 offLeft = motionPosReaches(&back, 0, last, -(left + MOTION_MARGIN));
+    return SDL_min(offRight, offLeft) + 1;
+}
+
+// Whatever floor a falling character lands on, it's no higher than the
+// highest floor under anywhere the character can be before the horizon. It
+// can't land before it has fallen that far.
+static Uint32 characterWhenLanded(const SC_Motion *m, Uint32 horizon)
+{
+    SC_MotionReal xMin, xMax, yMin, yMax;
+    motionPosRange(&m->x, horizon - 1, &xMin, &xMax);
+    motionPosRange(&m->y, horizon - 1, &yMin, &yMax);
+
+    SC_Real floorY = findFloorBound(m->level,
+        (SC_Real) (xMin - MOTION_MARGIN),
+        (SC_Real) (xMax + MOTION_MARGIN),
+        (SC_Real) (yMin - MOTION_MARGIN),
+        CHARACTER_HALF_WIDTH);
+    return motionPosReaches(&m->y, 1, horizon, floorY - MOTION_MARGIN);
+}
+
+// Per-state wake functions, from the same tick tables as the FSM. A state
+// can wake no later than the first of its conditions.
+
+#define CHARACTER_WAKE_ROW(condition, action, target) \
+    { \
+        Uint32 when = characterWhen##condition(m, wake); \
+        wake = SDL_min(wake, when); \
+    }
+
+#define CHARACTER_WAKE_FUNCTION(id, name, horizontal, vertical) \
+    static Uint32 characterWake##name(const SC_Motion *m) \
+    { \
+        Uint32 wake = MOTION_HORIZON; \
+        CHARACTER_TICKS_##id(CHARACTER_WAKE_ROW) \
+        return wake; \
+    }
+
+CHARACTER_STATES(CHARACTER_WAKE_FUNCTION)
+
+#define CHARACTER_WAKE_CASE(id, name, horizontal, vertical) \
+    case SC_CHARACTER_##id: wake = characterWake##name(&m); break;
+
+// Ticks from now until character i has to be checked again, at least 1
+static Uint32 characterWake(const SC_Characters *c, const SC_Level *l, Uint32 i, Uint32 delta)
+{
+    const SC_CharacterTuning *t = &c->tuning;
+
+    // The closed form starts from within the clamp, a faster character gets
+    // clamped by the next tick
+    if (REAL_ABS(c->velX[i]) > t->xVelMax || REAL_ABS(c->velY[i]) > t->yVelMax) {
+        return 1;
+    }
+
+    SC_Motion m = {
+        .c = c,
+        .i = i,
+        .level = l,
+        .x = motionAxis(c->posX[i], c->velX[i], c->accX[i], t->xVelMax, delta),
+        .y = motionAxis(c->posY[i], c->velY[i], c->accY[i], t->yVelMax, delta),
+    };
+    Uint32 wake = 1;
+
+    switch (c->state[i]) {
+    CHARACTER_STATES(CHARACTER_WAKE_CASE)
+    }
+
+    return wake > MOTION_MARGIN_TICKS ? wake - MOTION_MARGIN_TICKS : 1;
+}
+
+// Ticks characters in [begin, end) whose wake tick has come, the same way
+// tickCharactersJob does, and works out when they're next due. Input events
+// make a character due straight away, see eventCharacter.
+void tickCharactersPredicted(SC_Characters *c, const SC_Level *l, Uint32 begin, Uint32 end, Uint32 delta)
+{
+    for (Uint32 i = begin; i < end; i++) {
+        if (c->wakeIn[i] == 0) {
+            computeFloors(c, l, i, i + 1);
+        }
+    }
+
+    integrateCharacters(c, begin, end, delta, c->tuning.xVelMax, c->tuning.yVelMax);
+
+    for (Uint32 i = begin; i < end; i++) {
+        if (c->wakeIn[i] > 0) {
+            c->wakeIn[i]--;
+            continue;
+        }
+
+        Uint64 opts = 0;
+        int newState = characterTick(c, i, &opts);
+        if (newState != SC_FSM_NO_CHANGE) {
+            characterTransition(c, i, newState, &opts);
+        }
+        c->wakeIn[i] = (Uint16) (characterWake(c, l, i, delta) - 1);
+    }
+}
@@ -0,0 +1,179 @@
+#include <SDL3/SDL.h>
+
+#ifndef _WIN32
+#include <time.h>
+#endif
+
+// Frame pacing for the window, so a player standing still doesn't keep a
+// core busy. Frames are paced by vsync, or by sleeping until the next fixed
+// tick is due, and slowed right down while nobody can see the window. CPU
+// time is measured per frame, as running many instances on one machine is
+// what this is for. Headless runs and replays still run flat out.
+
+// About 30 fps while another window has the focus
+#define PACING_UNFOCUSED_MS 33
+
+// Only the simulation runs while the window can't be seen. Has to stay
+// under MAX_CATCHUP_TICKS ticks or it falls behind.
+#define PACING_HIDDEN_MS 100
+
+typedef enum SC_PacingMode {
+    SC_PACING_VSYNC, // Presenting waits for the display
+    SC_PACING_LIMIT, // Sleeps until the next fixed tick is due
+    SC_PACING_OFF,   // Flat out, for profiling
+} SC_PacingMode;
+
+static const char *pacingModeNames[] = { "vsync", "limit", "off" };
+
+typedef struct SC_Pacing {
+    SC_PacingMode mode;
+    bool hidden;
+    bool unfocused;
+
+    Uint64 frameStart; // SDL_GetTicksNS
+    Uint64 cpuStart;   // Process CPU time in ns, every thread
+
+    // Averages over the last second, for the overlay
+    Uint64 windowStart;
+    Uint64 windowCPU;
+    Uint32 windowFrames;
+    float fps;
+    float cpuMs;
+    float cpuShare; // Of one core, 1 is a whole core
+
+    Uint64 start;
+    Uint64 frames;
+    Uint64 totalCPU;
+} SC_Pacing;
+
+SC_Pacing pacing = {
+    .mode = SC_PACING_VSYNC,
+};
+
+// In ns, over every thread. Reads 0 without a POSIX process CPU clock.
+static Uint64 processCPUTime()
+{
+#ifndef _WIN32
+    struct timespec t;
+    if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t) != 0) {
+        return 0;
+    }
+    return (Uint64) t.tv_sec * SDL_NS_PER_SECOND + (Uint64) t.tv_nsec;
+#else
+    return 0;
+#endif
+}
+
+bool parsePacingMode(const char *name)
+{
+    for (Uint32 m = 0; m < SDL_arraysize(pacingModeNames); m++) {
+        if (SDL_strcmp(name, pacingModeNames[m]) == 0) {
+            pacing.mode = (SC_PacingMode) m;
+            return true;
+        }
+    }
+    SDL_Log("Unknown pacing mode: %s", name);
+    return false;
+}
+
+// Falls back to the limiter without vsync support
+void pacingStart(SDL_Renderer *renderer)
+{
+    if (pacing.mode == SC_PACING_VSYNC && !SDL_SetRenderVSync(renderer, 1)) {
+        SDL_Log("No vsync, pacing frames by sleeping instead: %s", SDL_GetError());
+        pacing.mode = SC_PACING_LIMIT;
+    }
+    if (pacing.mode != SC_PACING_VSYNC) {
+        SDL_SetRenderVSync(renderer, 0);
+    }
+
+    pacing.start = SDL_GetTicksNS();
+    pacing.frameStart = pacing.start;
+    pacing.windowStart = pacing.start;
+    pacing.cpuStart = processCPUTime();
+}
+
+// Whether this frame is worth drawing. Checks the window every frame rather
+// than tracking events, as not every platform sends them for occlusion.
+bool pacingShouldRender(SDL_Window *window)
+{
+    SDL_WindowFlags flags = SDL_GetWindowFlags(window);
+
+    pacing.hidden = (flags & (SDL_WINDOW_HIDDEN | SDL_WINDOW_MINIMIZED | SDL_WINDOW_OCCLUDED)) != 0;
+    pacing.unfocused = (flags & SDL_WINDOW_INPUT_FOCUS) == 0;
+    return !pacing.hidden;
+}
+
+// Sleeps off the rest of the frame, then counts the CPU time it took. The
+// limiter wakes up on the millisecond the next fixed tick of `s` is due, so
+// every frame it draws has a new step in it.
+void pacingEndFrame(const SC_AppState *s)
+{
+    Uint64 now = SDL_GetTicksNS();
+    Uint64 deadline = 0;
+
+    if (pacing.hidden) {
+        deadline = pacing.frameStart + SDL_MS_TO_NS(PACING_HIDDEN_MS);
+    } else if (pacing.unfocused) {
+        deadline = pacing.frameStart + SDL_MS_TO_NS(PACING_UNFOCUSED_MS);
+    } else if (pacing.mode == SC_PACING_LIMIT) {
+        deadline = SDL_MS_TO_NS(s->prevTick + FIXED_TICK_RATE - s->msAccum);
+    }
+
+    if (deadline > now) {
+        SDL_DelayPrecise(deadline - now);
+        now = SDL_GetTicksNS();
+    }
+
+    Uint64 cpu = processCPUTime();
+    Uint64 frameCPU = cpu - pacing.cpuStart;
+    pacing.cpuStart = cpu;
+    pacing.frameStart = now;
+    pacing.frames++;
+    pacing.totalCPU += frameCPU;
+    pacing.windowFrames++;
+    pacing.windowCPU += frameCPU;
+
+    Uint64 window = now - pacing.windowStart;
+    if (window >= SDL_NS_PER_SECOND) {
+        pacing.fps = (float) ((double) pacing.windowFrames * SDL_NS_PER_SECOND / (double) window);
+        pacing.cpuMs = (float) ((double) pacing.windowCPU / 1e6 / pacing.windowFrames);
+        pacing.cpuShare = (float) ((double) pacing.windowCPU / (double) window);
+        pacing.windowStart = now;
+        pacing.windowFrames = 0;
+        pacing.windowCPU = 0;
+    }
+}
+
+// One line under the frame timing overlay
+void pacingRenderOverlay(SDL_Renderer *renderer)
+{
+    if (!timing.overlay) {
+        return;
+    }
+
+    SDL_SetRenderScale(renderer, 2.0f, 2.0f);
+    SDL_SetRenderDrawColor(renderer, 160, 220, 255, SDL_ALPHA_OPAQUE);
+    SDL_RenderDebugTextFormat(renderer, 165.0f, 25.0f + 10.0f * SC_PHASE_TOTAL, "%-5s %5.1f fps, cpu %6.3f ms %3.0f%%",
+        pacingModeNames[pacing.mode],
+        pacing.fps,
+        pacing.cpuMs,
+        pacing.cpuShare * 100.0f);
+    SDL_SetRenderScale(renderer, 1.0f, 1.0f);
+}
+
+void pacingReport()
+{
+    Uint64 wall = SDL_GetTicksNS() - pacing.start;
+
+    if (pacing.frames == 0 || wall == 0) {
+        return;
+    }
+
+    SDL_Log("Pacing %s: %" SDL_PRIu64 " frames at %.1f fps, %.3f ms CPU per frame, %.1f%% of a core",
+        pacingModeNames[pacing.mode],
+        pacing.frames,
+        (double) pacing.frames * SDL_NS_PER_SECOND / (double) wall,
+        (double) pacing.totalCPU / 1e6 / (double) pacing.frames,
+        (double) pacing.totalCPU * 100.0 / (double) wall);
+}
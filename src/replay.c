@@ -0,0 +1,527 @@
+#include <SDL3/SDL.h>
+#include "types.h"
+#include "fsm.h"
+
+// Replays log everything that drives the simulation, keyed by fixed tick
+// rather than wall-clock time, so they play back at any speed with any
+// dispatch mode or thread count and must end in the same state.
+//
+// File layout, little endian apart from snapshot payloads (see snapshot.c):
+//   header   "SCRP", version, tick rate, start characters, flags, keyframe
+//            interval, level checksum
+//   records  a type byte followed by its payload
+//     INPUT     u8 event << 4 | key, applied before the next step
+//     STEP      u32 checksumAppState() after one fixed step
+//     KEYFRAME  u64 tick, u32 size, snapshot taken before that tick's inputs
+//     INDEX     u32 count, then u64 tick and u64 file offset per keyframe
+//   trailer  u64 offset of the INDEX record, "SCIX"
+// A log without its trailer, e.g. from a crashed recording, still plays. The
+// keyframe index is then rebuilt by scanning the records.
+
+#define REPLAY_MAGIC       0x50524353 // "SCRP"
+#define REPLAY_INDEX_MAGIC 0x58494353 // "SCIX"
+#define REPLAY_VERSION     5 // Bumped whenever the simulation changes behaviour
+#define REPLAY_HEADER_SIZE  28
+#define REPLAY_TRAILER_SIZE 12
+#define REPLAY_DEFAULT_KEYFRAME_INTERVAL 600
+#define REPLAY_BATCH_TICKS 1024
+
+#define REPLAY_FLAG_SCRIPT      0b01 // Characters also follow the headless script
+#define REPLAY_FLAG_FIXED_POINT 0b10 // Recorded by an SC_FIXED_POINT build
+
+#ifdef SC_FIXED_POINT
+#define REPLAY_BUILD_FLAGS REPLAY_FLAG_FIXED_POINT
+#else
+#define REPLAY_BUILD_FLAGS 0
+#endif
+
+typedef enum SC_ReplayRecord {
+    SC_REPLAY_INPUT    = 'I',
+    SC_REPLAY_STEP     = 'S',
+    SC_REPLAY_KEYFRAME = 'K',
+    SC_REPLAY_INDEX    = 'X',
+} SC_ReplayRecord;
+
+typedef struct SC_Keyframe {
+    Uint64 tick;
+    Uint64 offset; // Of the KEYFRAME record
+} SC_Keyframe;
+
+typedef struct SC_Replay {
+    const char *recordPath;
+    const char *playPath;
+    Uint64 seekTick;
+    Uint32 keyframeInterval;
+
+    SC_Keyframe *keyframes;
+    Uint32 numKeyframes;
+    Uint32 capKeyframes;
+
+    // Recording
+    SDL_IOStream *out;
+    Uint64 written;
+    void *snapshot;
+    size_t snapshotCapacity;
+    bool failed;
+
+    // Playback
+    bool playing;
+    Uint8 *data;
+    size_t size;
+    size_t pos;
+    Uint32 flags;
+    Uint32 numCharacters;
+    Uint32 levelChecksum;
+    Uint64 startTick;
+    Uint64 perfStart;
+    Uint64 perfSim;
+    bool diverged;
+} SC_Replay;
+
+SC_Replay replay = {
+    .keyframeInterval = REPLAY_DEFAULT_KEYFRAME_INTERVAL,
+};
+
+static bool addKeyframe(Uint64 tick, Uint64 offset)
+{
+    if (replay.numKeyframes == replay.capKeyframes) {
+        Uint32 cap = replay.capKeyframes > 0 ? replay.capKeyframes * 2 : 64;
+        SC_Keyframe *keyframes = SDL_realloc(replay.keyframes, cap * sizeof(SC_Keyframe));
+        if (keyframes == NULL) {
+            return false;
+        }
+        replay.keyframes = keyframes;
+        replay.capKeyframes = cap;
+    }
+
+    replay.keyframes[replay.numKeyframes++] = (SC_Keyframe) { tick, offset };
+    return true;
+}
+
+// RECORDING
+
+static void recordBytes(const void *p, size_t n)
+{
+    if (!replay.failed && SDL_WriteIO(replay.out, p, n) != n) {
+        SDL_Log("Failed to write replay: %s", SDL_GetError());
+        replay.failed = true;
+    }
+    replay.written += n;
+}
+
+static void recordU8(Uint8 v)
+{
+    recordBytes(&v, sizeof(v));
+}
+
+static void recordU32(Uint32 v)
+{
+    v = SDL_Swap32LE(v);
+    recordBytes(&v, sizeof(v));
+}
+
+static void recordU64(Uint64 v)
+{
+    v = SDL_Swap64LE(v);
+    recordBytes(&v, sizeof(v));
+}
+
+static void recordKeyframe(SC_AppState *s)
+{
+    size_t size = snapshotSize(s);
+
+    if (size > replay.snapshotCapacity) {
+        void *snapshot = SDL_realloc(replay.snapshot, size);
+        if (snapshot == NULL) {
+            return;
+        }
+        replay.snapshot = snapshot;
+        replay.snapshotCapacity = size;
+    }
+
+    if (!addKeyframe(s->tickCount, replay.written)) {
+        return;
+    }
+
+    saveSnapshot(s, replay.snapshot, size);
+    recordU8(SC_REPLAY_KEYFRAME);
+    recordU64(s->tickCount);
+    recordU32((Uint32) size);
+    recordBytes(replay.snapshot, size);
+}
+
+static void recordStep(SC_AppState *s, void *data)
+{
+    recordU8(SC_REPLAY_STEP);
+    recordU32(checksumAppState(s));
+
+    if (s->tickCount % replay.keyframeInterval == 0) {
+        recordKeyframe(s);
+    }
+}
+
+void recordInput(Uint64 event, Uint32 keyFlag)
+{
+    if (replay.out == NULL) {
+        return;
+    }
+
+    recordU8(SC_REPLAY_INPUT);
+    recordU8((Uint8) ((event << 4) | keyFlag));
+}
+
+bool recordStart(SC_AppState *s, Uint32 flags)
+{
+    replay.out = SDL_IOFromFile(replay.recordPath, "wb");
+    if (replay.out == NULL) {
+        SDL_Log("Failed to open %s: %s", replay.recordPath, SDL_GetError());
+        return false;
+    }
+
+    if (replay.keyframeInterval == 0) {
+        replay.keyframeInterval = REPLAY_DEFAULT_KEYFRAME_INTERVAL;
+    }
+
+    recordU32(REPLAY_MAGIC);
+    recordU32(REPLAY_VERSION);
+    recordU32(FIXED_TICK_RATE);
+    recordU32(s->numStartCharacters);
+    recordU32(flags | REPLAY_BUILD_FLAGS);
+    recordU32(replay.keyframeInterval);
+    recordU32(s->level->checksum);
+    recordKeyframe(s);
+
+    s->onStep = recordStep;
+    s->onStepData = NULL;
+    s->onInput = recordInput;
+
+    SDL_Log("Recording replay to %s", replay.recordPath);
+    return true;
+}
+
+void recordFinish()
+{
+    if (replay.out == NULL) {
+        return;
+    }
+
+    Uint64 indexOffset = replay.written;
+    recordU8(SC_REPLAY_INDEX);
+    recordU32(replay.numKeyframes);
+    for (Uint32 k = 0; k < replay.numKeyframes; k++) {
+        recordU64(replay.keyframes[k].tick);
+        recordU64(replay.keyframes[k].offset);
+    }
+    recordU64(indexOffset);
+    recordU32(REPLAY_INDEX_MAGIC);
+
+    if (!SDL_CloseIO(replay.out)) {
+        replay.failed = true;
+    }
+    replay.out = NULL;
+
+    SDL_Log("Recorded %" SDL_PRIu64 " bytes, %u keyframes%s",
+        replay.written, replay.numKeyframes, replay.failed ? " (write errors, replay is incomplete)" : "");
+}
+
+// PLAYBACK
+
+static bool readBytes(void *dst, size_t n)
+{
+    if (replay.size - replay.pos < n) {
+        return false;
+    }
+    SDL_memcpy(dst, replay.data + replay.pos, n);
+    replay.pos += n;
+    return true;
+}
+
+static bool readU8(Uint8 *v)
+{
+    return readBytes(v, sizeof(*v));
+}
+
+static bool readU32(Uint32 *v)
+{
+    if (!readBytes(v, sizeof(*v))) {
+        return false;
+    }
+    *v = SDL_Swap32LE(*v);
+    return true;
+}
+
+static bool readU64(Uint64 *v)
+{
+    if (!readBytes(v, sizeof(*v))) {
+        return false;
+    }
+    *v = SDL_Swap64LE(*v);
+    return true;
+}
+
+// Skips over the payload of a record whose type byte was just read. Returns
+// false on truncated or unknown records.
+static bool skipRecord(Uint8 type)
+{
+    Uint32 size;
+    Uint64 tick;
+
+    switch (type) {
+        case SC_REPLAY_INPUT:
+            return readBytes(&size, 1);
+        case SC_REPLAY_STEP:
+            return readU32(&size);
+        case SC_REPLAY_KEYFRAME:
+            if (!readU64(&tick) || !readU32(&size) || replay.size - replay.pos < size) {
+                return false;
+            }
+            replay.pos += size;
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool readIndex()
+{
+    if (replay.size < REPLAY_HEADER_SIZE + REPLAY_TRAILER_SIZE) {
+        return false;
+    }
+
+    Uint64 indexOffset;
+    Uint32 magic;
+    replay.pos = replay.size - REPLAY_TRAILER_SIZE;
+    readU64(&indexOffset);
+    readU32(&magic);
+    if (magic != REPLAY_INDEX_MAGIC || indexOffset < REPLAY_HEADER_SIZE || indexOffset >= replay.size) {
+        return false;
+    }
+
+    Uint8 type;
+    Uint32 count;
+    replay.pos = (size_t) indexOffset;
+    if (!readU8(&type) || type != SC_REPLAY_INDEX || !readU32(&count)) {
+        return false;
+    }
+
+    for (Uint32 k = 0; k < count; k++) {
+        Uint64 tick;
+        Uint64 offset;
+        if (!readU64(&tick) || !readU64(&offset) || offset >= indexOffset || !addKeyframe(tick, offset)) {
+            replay.numKeyframes = 0;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void scanIndex()
+{
+    replay.numKeyframes = 0;
+    replay.pos = REPLAY_HEADER_SIZE;
+
+    Uint8 type;
+    while (readU8(&type)) {
+        size_t offset = replay.pos - 1;
+        if (!skipRecord(type)) {
+            break;
+        }
+
+        // Only complete keyframes make it into the index
+        if (type == SC_REPLAY_KEYFRAME) {
+            Uint64 tick;
+            SDL_memcpy(&tick, replay.data + offset + 1, sizeof(tick));
+            if (!addKeyframe(SDL_Swap64LE(tick), offset)) {
+                break;
+            }
+        }
+    }
+}
+
+bool replayLoad()
+{
+    replay.data = SDL_LoadFile(replay.playPath, &replay.size);
+    if (replay.data == NULL) {
+        SDL_Log("Failed to load %s: %s", replay.playPath, SDL_GetError());
+        return false;
+    }
+
+    Uint32 magic = 0;
+    Uint32 version = 0;
+    Uint32 tickRate = 0;
+    replay.pos = 0;
+    readU32(&magic);
+    readU32(&version);
+    readU32(&tickRate);
+    readU32(&replay.numCharacters);
+    readU32(&replay.flags);
+    readU32(&replay.keyframeInterval);
+    readU32(&replay.levelChecksum);
+    if (magic != REPLAY_MAGIC || version != REPLAY_VERSION) {
+        SDL_Log("%s is not a version %d replay", replay.playPath, REPLAY_VERSION);
+        return false;
+    }
+    if (tickRate != FIXED_TICK_RATE) {
+        SDL_Log("%s was recorded at %u ms per tick, expected %d", replay.playPath, tickRate, FIXED_TICK_RATE);
+        return false;
+    }
+
+    if ((replay.flags & REPLAY_FLAG_FIXED_POINT) != REPLAY_BUILD_FLAGS) {
+        SDL_Log("%s was recorded with %s physics, this build uses %s", replay.playPath,
+            replay.flags & REPLAY_FLAG_FIXED_POINT ? "fixed point" : "float",
+            REPLAY_BUILD_FLAGS ? "fixed point" : "float");
+        return false;
+    }
+
+    if (!readIndex()) {
+        SDL_Log("%s has no keyframe index, rebuilding it", replay.playPath);
+        scanIndex();
+    }
+    if (replay.numKeyframes == 0) {
+        SDL_Log("%s has no keyframes", replay.playPath);
+        return false;
+    }
+
+    return true;
+}
+
+// Plays back up to the next STEP record and runs that step. Returns false at
+// the end of the log.
+static bool replayTick(SC_AppState *s)
+{
+    Uint64 now = (s->tickCount + 1) * FIXED_TICK_RATE;
+
+    if (replay.flags & REPLAY_FLAG_SCRIPT) {
+        headlessScriptStep(s, 0, now);
+    }
+
+    Uint8 type;
+    while (readU8(&type)) {
+        if (type == SC_REPLAY_INPUT) {
+            Uint8 input;
+            if (!readU8(&input)) {
+                return false;
+            }
+            handleInput(s, 0, input >> 4, input & 0x0F, now);
+        } else if (type == SC_REPLAY_STEP) {
+            Uint32 expected;
+            if (!readU32(&expected)) {
+                return false;
+            }
+
+            Uint64 perf = SDL_GetPerformanceCounter();
+            stepSimulation(s, now);
+            replay.perfSim += SDL_GetPerformanceCounter() - perf;
+
+            Uint32 actual = checksumAppState(s);
+            if (actual != expected && !replay.diverged) {
+                replay.diverged = true;
+                SDL_Log("Replay diverged at tick %" SDL_PRIu64 ": expected checksum %08x, got %08x",
+                    s->tickCount, expected, actual);
+            }
+            return true;
+        } else if (!skipRecord(type)) {
+            return false;
+        }
+    }
+
+    return false;
+}
+
+// Loads the last keyframe at or before `tick` and plays forward from it
+static bool replaySeek(SC_AppState *s, Uint64 tick)
+{
+    Uint32 lo = 0;
+    Uint32 hi = replay.numKeyframes;
+    while (hi - lo > 1) {
+        Uint32 mid = lo + (hi - lo) / 2;
+        if (replay.keyframes[mid].tick <= tick) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    Uint8 type;
+    Uint64 keyTick;
+    Uint32 size;
+    replay.pos = (size_t) replay.keyframes[lo].offset;
+    if (!readU8(&type) || type != SC_REPLAY_KEYFRAME || !readU64(&keyTick) || !readU32(&size)
+        || replay.size - replay.pos < size || !loadSnapshot(s, replay.data + replay.pos, size)) {
+        SDL_Log("Replay keyframe for tick %" SDL_PRIu64 " is corrupt", replay.keyframes[lo].tick);
+        return false;
+    }
+    replay.pos += size;
+
+    while (s->tickCount < tick) {
+        if (!replayTick(s)) {
+            SDL_Log("Replay ends at tick %" SDL_PRIu64 ", before tick %" SDL_PRIu64, s->tickCount, tick);
+            break;
+        }
+    }
+
+    return true;
+}
+
+bool replayStart(SC_AppState *s)
+{
+    // Keyframes don't hold the level, so it has to be given with --level
+    if (s->level->checksum != replay.levelChecksum) {
+        SDL_Log("%s was recorded on a different level, checksum %08x, this one is %08x",
+            replay.playPath, replay.levelChecksum, s->level->checksum);
+        return false;
+    }
+
+    headlessScriptInit();
+
+    Uint64 perf = SDL_GetPerformanceCounter();
+    if (!replaySeek(s, replay.seekTick)) {
+        return false;
+    }
+    perf = SDL_GetPerformanceCounter() - perf;
+
+    SDL_Log("Replay: %s, %u characters, %u keyframes, at tick %" SDL_PRIu64 " after %.3f ms seeking",
+        replay.playPath,
+        s->characters.count,
+        replay.numKeyframes,
+        s->tickCount,
+        (double) perf * 1e3 / (double) SDL_GetPerformanceFrequency());
+
+    replay.playing = true;
+    replay.startTick = s->tickCount;
+    replay.perfSim = 0;
+    replay.perfStart = SDL_GetPerformanceCounter();
+    return true;
+}
+
+SDL_AppResult replayIterate(SC_AppState *s)
+{
+    for (int i = 0; i < REPLAY_BATCH_TICKS; i++) {
+        if (!replayTick(s)) {
+            Uint64 ticks = s->tickCount - replay.startTick;
+            headlessReport(s, "Replay total", ticks, SDL_GetPerformanceCounter() - replay.perfStart);
+            headlessReport(s, "Replay simulation only", ticks, replay.perfSim);
+            SDL_Log("Replay %s at tick %" SDL_PRIu64, replay.diverged ? "DIVERGED, ended" : "matched", s->tickCount);
+            return replay.diverged ? SDL_APP_FAILURE : SDL_APP_SUCCESS;
+        }
+    }
+
+    return SDL_APP_CONTINUE;
+}
+
+void destroyReplay()
+{
+    recordFinish();
+
+    SDL_free(replay.data);
+    SDL_free(replay.keyframes);
+    SDL_free(replay.snapshot);
+    replay.data = NULL;
+    replay.keyframes = NULL;
+    replay.snapshot = NULL;
+    replay.numKeyframes = 0;
+    replay.capKeyframes = 0;
+    replay.snapshotCapacity = 0;
+    replay.playing = false;
+}
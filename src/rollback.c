@@ -0,0 +1,534 @@
+#include <SDL3/SDL.h>
+#include "types.h"
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+// Rollback netcode for two players, GGPO style. Each peer simulates every
+// tick straight away with the remote player's input predicted to be the last
+// one it received. When the real input turns out different, the peer loads
+// its snapshot from that tick and simulates forward again. Peers send every
+// input the other side hasn't acknowledged in each packet, so a lost packet
+// only delays input, it never loses it.
+//
+// --rollback-test runs two peers in one process over loopback UDP, with
+// packets held back and dropped on the way out to fake a real connection.
+// Time is simulated, one tick per frame, so a run takes as long as the
+// simulation and rollbacks do. At the end both peers and a reference that
+// had every input up front must agree.
+
+// Most ticks a peer runs ahead of the last input it has from the other.
+// Past that it waits, since every tick of prediction is a tick that may
+// have to be simulated again.
+#define ROLLBACK_MAX_FRAMES 8
+
+// Must be powers of two
+#define ROLLBACK_SNAPSHOTS 16 // More than ROLLBACK_MAX_FRAMES
+#define ROLLBACK_INPUTS    256
+
+#define ROLLBACK_MAGIC         0x42524353 // "SCRB"
+#define ROLLBACK_PACKET_INPUTS 64
+#define ROLLBACK_PACKET_SIZE   (3 * sizeof(Uint32) + 1 + ROLLBACK_PACKET_INPUTS)
+#define ROLLBACK_OUTBOX_SIZE   256
+
+#define ROLLBACK_DEFAULT_DELAY 60 // ms one way
+#define ROLLBACK_DEFAULT_LOSS  5  // percent
+
+// Scripted players hold a key combination for this many ticks
+#define ROLLBACK_SCRIPT_HOLD 12
+
+typedef struct SC_Rollback {
+    bool enabled;
+    Uint32 delay; // ms one way
+    Uint32 loss;  // percent
+    Uint64 random;
+} SC_Rollback;
+
+SC_Rollback rollback = {
+    .enabled = false,
+    .delay = ROLLBACK_DEFAULT_DELAY,
+    .loss = ROLLBACK_DEFAULT_LOSS,
+    .random = 0x2545F4914F6CDD1D,
+};
+
+// The peers and everything up to rollbackTest need POSIX sockets
+#ifndef _WIN32
+
+typedef struct SC_DelayedPacket {
+    Uint64 sendAt; // Simulated ms
+    Uint8 bytes[ROLLBACK_PACKET_SIZE];
+    int size;
+} SC_DelayedPacket;
+
+typedef struct SC_RollbackPeer {
+    SC_AppState *s;
+    Uint32 local;  // Player index this peer's input drives
+    Uint32 remote;
+    int socket;
+    struct sockaddr_in remoteAddr;
+
+    // Input of each player by tick, as keysDown bits. The remote player's
+    // entries past `confirmed` are predictions.
+    Uint8 inputs[SC_MAX_PLAYERS][ROLLBACK_INPUTS];
+    Uint64 confirmed;    // Remote input is known for ticks before this
+    Uint64 remoteAck;    // The remote has local input for ticks before this
+    Uint64 rollbackFrom; // First mispredicted tick, or SDL_MAX_UINT64
+
+    // State at the start of each recent tick
+    void *snapshots[ROLLBACK_SNAPSHOTS];
+    size_t snapshotSizes[ROLLBACK_SNAPSHOTS];
+    size_t snapshotCapacity;
+
+    // Packets waiting out the fake latency
+    SC_DelayedPacket outbox[ROLLBACK_OUTBOX_SIZE];
+    Uint32 outboxHead;
+    Uint32 outboxTail;
+
+    Uint64 rollbacks;
+    Uint64 resimulated;
+    Uint64 maxDepth;
+    Uint64 stalls;
+    Uint64 packetsSent;
+    Uint64 packetsDropped;
+    Uint64 perfSave;
+    Uint64 perfLoad;
+    Uint64 perfStep;   // Ticks simulated for the first time
+    Uint64 perfResim;  // Ticks simulated again after a rollback
+} SC_RollbackPeer;
+
+// xorshift, seeded the same every run so runs can be compared
+static Uint32 rollbackRandom()
+{
+    rollback.random ^= rollback.random << 13;
+    rollback.random ^= rollback.random >> 7;
+    rollback.random ^= rollback.random << 17;
+    return (Uint32) (rollback.random >> 32);
+}
+
+// Stand-in for a player at the keyboard: a fresh key combination every
+// ROLLBACK_SCRIPT_HOLD ticks, the same on every peer
+static Uint8 rollbackScriptInput(Uint32 player, Uint64 tick)
+{
+    Uint32 h = (Uint32) (tick / ROLLBACK_SCRIPT_HOLD) * 0x9E3779B1u ^ (player + 1) * 0x85EBCA6Bu;
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    h ^= h >> 12;
+    return (Uint8) (h & (KEY_RIGHT | KEY_LEFT | KEY_JUMP));
+}
+
+// Presses and releases keys so player `p` holds `keys`
+static void setPlayerKeys(SC_AppState *s, Uint32 p, Uint32 keys, Uint64 now)
+{
+    static const Uint32 flags[] = { KEY_RIGHT, KEY_LEFT, KEY_JUMP };
+
+    for (Uint32 k = 0; k < SDL_arraysize(flags); k++) {
+        Uint32 was = s->keysDown[p] & flags[k];
+        Uint32 is = keys & flags[k];
+        if (was != is) {
+            handleInput(s, p, is ? SC_EVENT_KEYDOWN : SC_EVENT_KEYUP, flags[k], now);
+        }
+    }
+}
+
+// Runs tick s->tickCount with each player holding `keys`. Characters that
+// aren't players follow the headless script.
+static void stepWithInputs(SC_AppState *s, const Uint8 keys[SC_MAX_PLAYERS])
+{
+    Uint64 now = (s->tickCount + 1) * FIXED_TICK_RATE;
+
+    for (Uint32 p = 0; p < s->numPlayers; p++) {
+        setPlayerKeys(s, p, keys[p], now);
+    }
+    headlessScriptStep(s, s->numPlayers, now);
+    stepSimulation(s, now);
+}
+
+static bool saveRollbackSnapshot(SC_RollbackPeer *peer)
+{
+    SC_AppState *s = peer->s;
+    Uint32 slot = s->tickCount % ROLLBACK_SNAPSHOTS;
+    size_t size = snapshotSize(s);
+
+    // Every slot grows together, so the pool stays one size
+    if (size > peer->snapshotCapacity) {
+        for (Uint32 k = 0; k < ROLLBACK_SNAPSHOTS; k++) {
+            void *snapshot = SDL_realloc(peer->snapshots[k], size);
+            if (snapshot == NULL) {
+                return false;
+            }
+            peer->snapshots[k] = snapshot;
+        }
+        peer->snapshotCapacity = size;
+    }
+
+    Uint64 perf = SDL_GetPerformanceCounter();
+    peer->snapshotSizes[slot] = saveSnapshot(s, peer->snapshots[slot], peer->snapshotCapacity);
+    peer->perfSave += SDL_GetPerformanceCounter() - perf;
+    return peer->snapshotSizes[slot] > 0;
+}
+
+// Simulates tick s->tickCount, predicting the remote input if it isn't
+// known yet
+static bool rollbackStep(SC_RollbackPeer *peer)
+{
+    SC_AppState *s = peer->s;
+    Uint64 tick = s->tickCount;
+    Uint32 slot = tick % ROLLBACK_INPUTS;
+
+    if (tick >= peer->confirmed) {
+        peer->inputs[peer->remote][slot] = peer->confirmed > 0
+            ? peer->inputs[peer->remote][(peer->confirmed - 1) % ROLLBACK_INPUTS]
+            : 0;
+    }
+
+    if (!saveRollbackSnapshot(peer)) {
+        return false;
+    }
+
+    Uint8 keys[SC_MAX_PLAYERS];
+    for (Uint32 p = 0; p < SC_MAX_PLAYERS; p++) {
+        keys[p] = peer->inputs[p][slot];
+    }
+    stepWithInputs(s, keys);
+    return true;
+}
+
+// Goes back to the first mispredicted tick and simulates up to the present
+// again with what is known now
+static bool rollbackResimulate(SC_RollbackPeer *peer)
+{
+    SC_AppState *s = peer->s;
+    Uint64 target = s->tickCount;
+    Uint64 from = peer->rollbackFrom;
+    Uint32 slot = from % ROLLBACK_SNAPSHOTS;
+
+    peer->rollbackFrom = SDL_MAX_UINT64;
+    if (from >= target) {
+        return true;
+    }
+
+    Uint64 perf = SDL_GetPerformanceCounter();
+    if (!loadSnapshot(s, peer->snapshots[slot], peer->snapshotSizes[slot]) || s->tickCount != from) {
+        SDL_Log("Rollback snapshot for tick %" SDL_PRIu64 " is missing", from);
+        return false;
+    }
+    Uint64 perfLoaded = SDL_GetPerformanceCounter();
+    peer->perfLoad += perfLoaded - perf;
+
+    while (s->tickCount < target) {
+        if (!rollbackStep(peer)) {
+            return false;
+        }
+    }
+
+    Uint64 depth = target - from;
+    peer->perfResim += SDL_GetPerformanceCounter() - perfLoaded;
+    peer->rollbacks++;
+    peer->resimulated += depth;
+    peer->maxDepth = SDL_max(peer->maxDepth, depth);
+    return true;
+}
+
+// PACKETS
+//
+// Little endian: magic, first tick, ack, count, then count input bytes for
+// ticks first tick onwards. The ack is the number of ticks of the
+// receiver's input the sender has.
+
+static void putU32(Uint8 *p, Uint32 v)
+{
+    v = SDL_Swap32LE(v);
+    SDL_memcpy(p, &v, sizeof(v));
+}
+
+static Uint32 getU32(const Uint8 *p)
+{
+    Uint32 v;
+    SDL_memcpy(&v, p, sizeof(v));
+    return SDL_Swap32LE(v);
+}
+
+static void sendInputs(SC_RollbackPeer *peer, Uint64 now)
+{
+    Uint64 first = peer->remoteAck;
+    Uint64 end = peer->s->tickCount;
+    if (first >= end) {
+        return;
+    }
+    Uint32 count = (Uint32) SDL_min(end - first, ROLLBACK_PACKET_INPUTS);
+
+    if (rollbackRandom() % 100 < rollback.loss) {
+        peer->packetsDropped++;
+        return;
+    }
+    if (peer->outboxTail - peer->outboxHead == ROLLBACK_OUTBOX_SIZE) {
+        peer->packetsDropped++;
+        return;
+    }
+
+    SC_DelayedPacket *packet = &peer->outbox[peer->outboxTail++ % ROLLBACK_OUTBOX_SIZE];
+    packet->sendAt = now + rollback.delay;
+    putU32(packet->bytes, ROLLBACK_MAGIC);
+    putU32(packet->bytes + 4, (Uint32) first);
+    putU32(packet->bytes + 8, (Uint32) peer->confirmed);
+    packet->bytes[12] = (Uint8) count;
+    for (Uint32 k = 0; k < count; k++) {
+        packet->bytes[13 + k] = peer->inputs[peer->local][(first + k) % ROLLBACK_INPUTS];
+    }
+    packet->size = 13 + (int) count;
+}
+
+static void flushOutbox(SC_RollbackPeer *peer, Uint64 now)
+{
+    while (peer->outboxHead != peer->outboxTail) {
+        SC_DelayedPacket *packet = &peer->outbox[peer->outboxHead % ROLLBACK_OUTBOX_SIZE];
+        if (packet->sendAt > now) {
+            break;
+        }
+        sendto(peer->socket, packet->bytes, packet->size, 0, (struct sockaddr *) &peer->remoteAddr, sizeof(peer->remoteAddr));
+        peer->packetsSent++;
+        peer->outboxHead++;
+    }
+}
+
+static void receiveInputs(SC_RollbackPeer *peer)
+{
+    Uint8 bytes[ROLLBACK_PACKET_SIZE];
+
+    for (;;) {
+        ssize_t size = recv(peer->socket, bytes, sizeof(bytes), 0);
+        if (size < 13 || getU32(bytes) != ROLLBACK_MAGIC || size < 13 + bytes[12]) {
+            if (size < 0) {
+                return;
+            }
+            continue;
+        }
+
+        Uint64 first = getU32(bytes + 4);
+        Uint64 ack = getU32(bytes + 8);
+        Uint32 count = bytes[12];
+        peer->remoteAck = SDL_max(peer->remoteAck, ack);
+
+        // Only the next unknown tick onwards is new, anything later would
+        // leave a gap and can't arrive without it anyway
+        for (Uint64 tick = peer->confirmed; tick < first + count && tick >= first; tick++) {
+            Uint8 *slot = &peer->inputs[peer->remote][tick % ROLLBACK_INPUTS];
+            Uint8 input = bytes[13 + (tick - first)];
+
+            if (tick < peer->s->tickCount && *slot != input) {
+                peer->rollbackFrom = SDL_min(peer->rollbackFrom, tick);
+            }
+            *slot = input;
+            peer->confirmed = tick + 1;
+        }
+    }
+}
+
+// One frame of a peer: take in what arrived, fix up mispredictions, then
+// move on a tick unless too far ahead of the remote
+static bool rollbackFrame(SC_RollbackPeer *peer, Uint64 now, Uint64 ticksTotal)
+{
+    flushOutbox(peer, now);
+    receiveInputs(peer);
+
+    if (!rollbackResimulate(peer)) {
+        return false;
+    }
+
+    SC_AppState *s = peer->s;
+    if (s->tickCount < ticksTotal) {
+        if (s->tickCount >= peer->confirmed + ROLLBACK_MAX_FRAMES) {
+            peer->stalls++;
+        } else {
+            peer->inputs[peer->local][s->tickCount % ROLLBACK_INPUTS] = rollbackScriptInput(peer->local, s->tickCount);
+
+            Uint64 perf = SDL_GetPerformanceCounter();
+            if (!rollbackStep(peer)) {
+                return false;
+            }
+            peer->perfStep += SDL_GetPerformanceCounter() - perf;
+        }
+    }
+
+    sendInputs(peer, now);
+    return true;
+}
+
+static bool openPeerSocket(SC_RollbackPeer *peer)
+{
+    struct sockaddr_in addr = { 0 };
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+
+    peer->socket = socket(AF_INET, SOCK_DGRAM, 0);
+    if (peer->socket < 0 || bind(peer->socket, (struct sockaddr *) &addr, sizeof(addr)) != 0
+        || fcntl(peer->socket, F_SETFL, O_NONBLOCK) != 0) {
+        SDL_Log("Failed to open a loopback UDP socket: %s", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+static bool connectPeers(SC_RollbackPeer *a, SC_RollbackPeer *b)
+{
+    socklen_t size = sizeof(struct sockaddr_in);
+    return getsockname(a->socket, (struct sockaddr *) &b->remoteAddr, &size) == 0
+        && getsockname(b->socket, (struct sockaddr *) &a->remoteAddr, &size) == 0;
+}
+
+static SC_AppState *initRollbackState(Uint32 numCharacters, const SC_Level *level, SC_DispatchMode mode, SC_Workers *workers)
+{
+    SC_AppState *s = initAppState(0, SDL_max(numCharacters, SC_MAX_PLAYERS));
+    if (s == NULL) {
+        return NULL;
+    }
+    s->dispatchMode = mode;
+    s->workers = workers;
+    s->numPlayers = SC_MAX_PLAYERS;
+    setLevel(s, level, 0);
+    return s;
+}
+
+static void destroyRollbackPeer(SC_RollbackPeer *peer)
+{
+    if (peer->socket >= 0) {
+        close(peer->socket);
+    }
+    for (Uint32 k = 0; k < ROLLBACK_SNAPSHOTS; k++) {
+        SDL_free(peer->snapshots[k]);
+    }
+    destroyAppState(peer->s);
+}
+
+static double perfMicros(Uint64 perf, Uint64 count)
+{
+    return count > 0 ? (double) perf * 1e6 / (double) SDL_GetPerformanceFrequency() / (double) count : 0.0;
+}
+
+static void rollbackReport(const SC_RollbackPeer *peer, Uint64 frames)
+{
+    Uint64 ticks = peer->s->tickCount;
+    double stepUs = perfMicros(peer->perfStep, ticks);
+    double resimUs = perfMicros(peer->perfResim, peer->resimulated);
+    double loadUs = perfMicros(peer->perfLoad, peer->rollbacks);
+    double saveUs = perfMicros(peer->perfSave, ticks + peer->resimulated);
+
+    SDL_Log("Peer %u: %" SDL_PRIu64 " rollbacks, %.2f ticks deep on average, %" SDL_PRIu64 " at most, %" SDL_PRIu64 " stalled frames",
+        peer->local + 1, peer->rollbacks,
+        peer->rollbacks > 0 ? (double) peer->resimulated / (double) peer->rollbacks : 0.0,
+        peer->maxDepth, peer->stalls);
+    SDL_Log("Peer %u: %.2f resimulated ticks per frame, %" SDL_PRIu64 " packets sent, %" SDL_PRIu64 " dropped",
+        peer->local + 1, (double) peer->resimulated / (double) frames, peer->packetsSent, peer->packetsDropped);
+    SDL_Log("Peer %u: tick %.2f us, resimulated tick %.2f us, snapshot save %.2f us, load %.2f us",
+        peer->local + 1, stepUs, resimUs, saveUs, loadUs);
+
+    // A frame has FIXED_TICK_RATE ms for its own tick, a rollback and the
+    // ticks simulated again
+    double spare = FIXED_TICK_RATE * 1000.0 - stepUs - loadUs;
+    double perResim = resimUs > 0.0 ? resimUs : stepUs + saveUs;
+    if (perResim > 0.0) {
+        SDL_Log("Peer %u: a %d ms frame affords %.0f rollback ticks with %u characters",
+            peer->local + 1, FIXED_TICK_RATE, spare / perResim, peer->s->characters.count);
+    }
+}
+
+#endif
+
+// --rollback-test
+bool rollbackTest(Uint64 ticksTotal, Uint32 numCharacters, const SC_Level *level, SC_DispatchMode mode, SC_Workers *workers)
+{
+#ifdef _WIN32
+    SDL_Log("--rollback-test needs POSIX sockets");
+    return false;
+#else
+    headlessScriptInit();
+    if (ticksTotal == 0) {
+        ticksTotal = HEADLESS_DEFAULT_TICKS;
+    }
+
+    SC_RollbackPeer peers[SC_MAX_PLAYERS];
+    SDL_zeroa(peers);
+    bool ok = true;
+    for (Uint32 p = 0; p < SC_MAX_PLAYERS; p++) {
+        peers[p].local = p;
+        peers[p].remote = 1 - p;
+        peers[p].socket = -1;
+        peers[p].rollbackFrom = SDL_MAX_UINT64;
+        peers[p].s = initRollbackState(numCharacters, level, mode, workers);
+        ok = ok && peers[p].s != NULL && openPeerSocket(&peers[p]);
+    }
+    ok = ok && connectPeers(&peers[0], &peers[1]);
+
+    SDL_Log("Rollback test: %" SDL_PRIu64 " ticks, %u characters, %u ms delay, %u%% loss",
+        ticksTotal, ok ? peers[0].s->characters.count : 0, rollback.delay, rollback.loss);
+
+    // Runs until both peers have every tick with the real inputs. The frame
+    // limit only matters if nothing gets through.
+    Uint64 frames = 0;
+    Uint64 framesMax = ticksTotal * 4 + 10000;
+    while (ok && frames < framesMax) {
+        bool done = true;
+        for (Uint32 p = 0; p < SC_MAX_PLAYERS; p++) {
+            done = done && peers[p].s->tickCount == ticksTotal && peers[p].confirmed == ticksTotal;
+        }
+        if (done) {
+            break;
+        }
+
+        Uint64 now = frames * FIXED_TICK_RATE;
+        for (Uint32 p = 0; p < SC_MAX_PLAYERS && ok; p++) {
+            ok = rollbackFrame(&peers[p], now, ticksTotal);
+        }
+        frames++;
+    }
+
+    // A peer's inputs are confirmed once it has the other's, so the last
+    // tick each resimulated has both players' real input in it
+    SC_AppState *reference = ok ? initRollbackState(numCharacters, level, mode, workers) : NULL;
+    if (reference != NULL) {
+        while (reference->tickCount < ticksTotal) {
+            Uint8 keys[SC_MAX_PLAYERS];
+            for (Uint32 p = 0; p < SC_MAX_PLAYERS; p++) {
+                keys[p] = rollbackScriptInput(p, reference->tickCount);
+            }
+            stepWithInputs(reference, keys);
+        }
+
+        for (Uint32 p = 0; p < SC_MAX_PLAYERS; p++) {
+            rollbackReport(&peers[p], frames);
+        }
+
+        Uint32 expected = checksumAppState(reference);
+        for (Uint32 p = 0; p < SC_MAX_PLAYERS; p++) {
+            Uint32 actual = checksumAppState(peers[p].s);
+            if (peers[p].s->tickCount != ticksTotal || peers[p].confirmed != ticksTotal) {
+                SDL_Log("Peer %u never caught up: at tick %" SDL_PRIu64 " with remote input up to tick %" SDL_PRIu64,
+                    p + 1, peers[p].s->tickCount, peers[p].confirmed);
+                ok = false;
+            } else if (actual != expected) {
+                SDL_Log("Peer %u DIVERGED: checksum %08x, expected %08x", p + 1, actual, expected);
+                ok = false;
+            }
+        }
+        if (ok) {
+            SDL_Log("Rollback matched after %" SDL_PRIu64 " frames, checksum %08x", frames, expected);
+        }
+        destroyAppState(reference);
+    } else {
+        ok = false;
+    }
+
+    for (Uint32 p = 0; p < SC_MAX_PLAYERS; p++) {
+        destroyRollbackPeer(&peers[p]);
+    }
+    return ok;
+#endif
+}
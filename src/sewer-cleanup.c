@@ -3,99 +3,335 @@
 #include <SDL3/SDL_main.h>
 #include "types.h"
 #include "fsm.h"
-#include "fsm-character.c"
+#include "simulation.c"
+#include "headless.c"
+#include "bench.c"
+#include "replay.c"
+#include "rollback.c"
+#include "sweep.c"
+#include "timing.c"
+#include "pacing.c"
+#include "batch.c"
+#include "atlas.c"
+#include "hud.c"
+
+#define WORKERS_DEFAULT_THREADS 1
 
 #define WINDOW_WIDTH 960
 #define WINDOW_HEIGHT 720
 
-#define FIXED_TICK_RATE 16
-
 SDL_Window *window;
 SDL_Renderer *renderer;
 
-#define SC_EVENT_KEYUP   0b0
-#define SC_EVENT_KEYDOWN 0b1
+// One SDL_RenderGeometry call each per frame
+SC_RenderBatch worldBatch;
+SC_RenderBatch characterBatch;
+SC_RenderBatch enemyBatch;
+
+// Character sprites, packed by bin/build-assets.sh. Without it characters
+// are drawn as rects.
+#define ATLAS_PATH "assets/sprites.scat"
+SC_Atlas atlas;
+
+// The static world, drawn once and copied to the screen every frame. Set
+// backgroundDirty whenever the level changes.
+SDL_Texture *background;
+bool backgroundDirty = true;
+
+const SDL_FColor lineColor = { 1.0f, 1.0f, 1.0f, 1.0f };
+const SDL_FColor characterBodyColor = { 254 / 255.0f, 231 / 255.0f, 97 / 255.0f, 1.0f };
+const SDL_FColor characterHeadColor = { 0.0f, 0.0f, 0.0f, 1.0f };
+const SDL_FColor enemyKindColors[] = {
+    { 94 / 255.0f, 201 / 255.0f, 98 / 255.0f, 1.0f },
+    { 80 / 255.0f, 150 / 255.0f, 240 / 255.0f, 1.0f },
+    { 232 / 255.0f, 84 / 255.0f, 70 / 255.0f, 1.0f },
+};
+const SDL_FColor enemyDieColor = { 0.5f, 0.5f, 0.5f, 1.0f };
+
+SC_DispatchMode dispatchMode = SC_DISPATCH_DIRECT;
+int numThreads = WORKERS_DEFAULT_THREADS;
+bool numThreadsGiven = false;
+SC_Workers *workers;
+bool benchDispatchEnabled = false;
+bool benchThreadsEnabled = false;
+bool benchFSMEnabled = false;
+Uint32 numArenaEnemies = 0; // --enemies, 0 follows the level's schedule
+
+// --level files. The first is played from the start; Tab moves on to the
+// next one in windowed mode. Only the current one is mapped.
+#define MAX_LEVELS 16
+const char *levelPaths[MAX_LEVELS];
+int numLevelPaths = 0;
+int currentLevel = 0;
+SC_Level loadedLevel;
+const char *compileLevelPaths[2];
+const char *packAtlasPaths[2];
+
+void drawWorld(const SC_Level *level)
+{
+    float ground = REAL_TO_FLOAT(level->groundY);
+    batchLine(&worldBatch, 0, ground, WINDOW_WIDTH, ground, lineColor);
 
-#define KEY_RIGHT 0b0001
-#define KEY_LEFT  0b0010
-#define KEY_JUMP  0b0100
+    for (Uint32 p = 0; p < level->numPlatforms; p++) {
+        const SC_Platform *platform = &level->platforms[p];
+        float y = (float) platform->top;
+        batchLine(&worldBatch, (float) platform->left, y, (float) platform->right, y, lineColor);
+    }
+    flushRenderBatch(renderer, &worldBatch);
+}
 
-void resetPlayer(SC_Character* player, Uint64 now)
+// Without render target support the world is drawn every frame instead
+void createBackground()
 {
-    player->pos.x = 200.0f;
-    player->pos.y = GROUND_Y;
-    player->vel.x = 0.0f;
-    player->vel.y = 0.0f;
-    player->acc.x = 0.0f;
-    player->acc.y = 0.0f;
-    player->flags = CHARACTER_FLAG_FACE_RIGHT;
-    player->state = SC_CHARACTER_STAND;
+    SDL_DestroyTexture(background);
+    background = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, WINDOW_WIDTH, WINDOW_HEIGHT);
+    if (background == NULL) {
+        SDL_Log("Failed to create background texture, drawing the world every frame: %s", SDL_GetError());
+    } else {
+        SDL_SetTextureBlendMode(background, SDL_BLENDMODE_NONE);
+    }
+    backgroundDirty = true;
 }
 
-void resetAppState(SC_AppState *scAppState, Uint64 now)
+void renderBackground(const SC_Level *level)
 {
-    scAppState->prevTick = now;
-    scAppState->keysDown = 0;
-    scAppState->numCharacters = 1;
-    scAppState->characters = SDL_calloc(5, sizeof(SC_Character));
-    resetPlayer(scAppState->characters, now);
+    if (background == NULL) {
+        drawWorld(level);
+        return;
+    }
+
+    if (backgroundDirty) {
+        SDL_SetRenderTarget(renderer, background);
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, SDL_ALPHA_OPAQUE);
+        SDL_RenderClear(renderer);
+        drawWorld(level);
+        SDL_SetRenderTarget(renderer, NULL);
+        backgroundDirty = false;
+    }
+
+    SDL_RenderTexture(renderer, background, NULL, NULL);
 }
 
-SC_AppState* initAppState(Uint64 now)
+bool parseArgs(int argc, char *argv[])
 {
-    initCharacterFSM();
+    for (int i = 1; i < argc; i++) {
+        if (SDL_strcmp(argv[i], "--headless") == 0) {
+            headless.enabled = true;
+        } else if (SDL_strcmp(argv[i], "--dispatch") == 0 && i + 1 < argc) {
+            i++;
+            if (SDL_strcmp(argv[i], "batch") == 0) {
+                dispatchMode = SC_DISPATCH_BATCH;
+            } else if (SDL_strcmp(argv[i], "direct") == 0) {
+                dispatchMode = SC_DISPATCH_DIRECT;
+            } else if (SDL_strcmp(argv[i], "predicted") == 0) {
+                dispatchMode = SC_DISPATCH_PREDICTED;
+            } else {
+                SDL_Log("Unknown dispatch mode: %s", argv[i]);
+                return false;
+            }
+        } else if (SDL_strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            numThreads = SDL_atoi(argv[++i]);
+            numThreadsGiven = true;
+        } else if (SDL_strcmp(argv[i], "--bench-dispatch") == 0) {
+            benchDispatchEnabled = true;
+        } else if (SDL_strcmp(argv[i], "--bench-threads") == 0) {
+            benchThreadsEnabled = true;
+        } else if (SDL_strcmp(argv[i], "--bench-fsm") == 0) {
+            benchFSMEnabled = true;
+        } else if (SDL_strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) {
+            headless.ticksTotal = SDL_strtoull(argv[++i], NULL, 10);
+        } else if (SDL_strcmp(argv[i], "--characters") == 0 && i + 1 < argc) {
+            headless.numCharacters = (Uint32) SDL_strtoull(argv[++i], NULL, 10);
+        } else if (SDL_strcmp(argv[i], "--enemies") == 0 && i + 1 < argc) {
+            numArenaEnemies = (Uint32) SDL_strtoull(argv[++i], NULL, 10);
+        } else if (SDL_strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            replay.recordPath = argv[++i];
+        } else if (SDL_strcmp(argv[i], "--keyframe-interval") == 0 && i + 1 < argc) {
+            replay.keyframeInterval = (Uint32) SDL_strtoull(argv[++i], NULL, 10);
+        } else if (SDL_strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replay.playPath = argv[++i];
+        } else if (SDL_strcmp(argv[i], "--seek") == 0 && i + 1 < argc) {
+            replay.seekTick = SDL_strtoull(argv[++i], NULL, 10);
+        } else if (SDL_strcmp(argv[i], "--level") == 0 && i + 1 < argc) {
+            if (numLevelPaths == MAX_LEVELS) {
+                SDL_Log("At most %d levels", MAX_LEVELS);
+                return false;
+            }
+            levelPaths[numLevelPaths++] = argv[++i];
+        } else if (SDL_strcmp(argv[i], "--compile-level") == 0 && i + 2 < argc) {
+            compileLevelPaths[0] = argv[++i];
+            compileLevelPaths[1] = argv[++i];
+        } else if (SDL_strcmp(argv[i], "--pack-atlas") == 0 && i + 2 < argc) {
+            packAtlasPaths[0] = argv[++i];
+            packAtlasPaths[1] = argv[++i];
+        } else if (SDL_strcmp(argv[i], "--rollback-test") == 0) {
+            rollback.enabled = true;
+        } else if (SDL_strcmp(argv[i], "--rollback-delay") == 0 && i + 1 < argc) {
+            rollback.delay = (Uint32) SDL_strtoull(argv[++i], NULL, 10);
+        } else if (SDL_strcmp(argv[i], "--rollback-loss") == 0 && i + 1 < argc) {
+            rollback.loss = (Uint32) SDL_strtoull(argv[++i], NULL, 10);
+        } else if (SDL_strcmp(argv[i], "--sweep") == 0 && i + 1 < argc) {
+            sweep.path = argv[++i];
+        } else if (SDL_strcmp(argv[i], "--sweep-csv") == 0 && i + 1 < argc) {
+            sweep.csvPath = argv[++i];
+        } else if (SDL_strcmp(argv[i], "--pacing") == 0 && i + 1 < argc) {
+            if (!parsePacingMode(argv[++i])) {
+                return false;
+            }
+        } else if (SDL_strcmp(argv[i], "--timing") == 0) {
+            timing.overlay = true;
+        } else if (SDL_strcmp(argv[i], "--timing-csv") == 0 && i + 1 < argc) {
+            timing.csvPath = argv[++i];
+        } else {
+            SDL_Log("Unknown argument: %s", argv[i]);
+            SDL_Log("Usage: %s [--headless] [--ticks N] [--characters N] [--enemies N] [--dispatch direct|batch|predicted] [--threads N] [--bench-dispatch] [--bench-threads] [--bench-fsm] [--level FILE]... [--compile-level TEXT OUT] [--pack-atlas DIR OUT] [--record FILE] [--keyframe-interval N] [--replay FILE] [--seek N] [--rollback-test] [--rollback-delay MS] [--rollback-loss PERCENT] [--sweep FILE] [--sweep-csv FILE] [--pacing vsync|limit|off] [--timing] [--timing-csv FILE]", argv[0]);
+            return false;
+        }
+    }
 
-    SC_AppState *scAppState = (SC_AppState *) SDL_malloc(sizeof(SC_AppState));
-    scAppState->msAccum = 0;
-    resetAppState(scAppState, now);
-    return scAppState;
+    return true;
 }
 
-
-void eventCharacter(SC_Character *c, SC_Event e, Uint64 now, Uint64 opts)
+// Maps level `n` of the --level files and restarts on it. The current level
+// stays if it fails to load.
+bool useLevel(SC_AppState *s, int n, Uint64 now)
 {
-    int newMoveState = FSMsCharacter[c->state].input(c, e, now, &opts);
-
-    if (newMoveState != SC_FSM_NO_CHANGE) {
-        //SDL_Log("Leave %d, Enter %d", c->state, newMoveState);
-        FSMsCharacter[c->state].exit(c, &opts);
-        c->state = newMoveState;
-        FSMsCharacter[c->state].enter(c, &opts);
+    Uint64 perf = SDL_GetPerformanceCounter();
+    if (!loadLevel(&loadedLevel, levelPaths[n])) {
+        return false;
     }
+    perf = SDL_GetPerformanceCounter() - perf;
+
+    currentLevel = n;
+    setLevel(s, &loadedLevel, now);
+    backgroundDirty = true;
+    SDL_Log("Level %s: %u platforms, %u pipes, loaded in %.1f us", levelPaths[n],
+        loadedLevel.numPlatforms, loadedLevel.numPipes, (double) perf * 1e6 / (double) SDL_GetPerformanceFrequency());
+    return true;
 }
 
-
-void tickCharacters(SC_AppState *scAppState, Uint64 delta, Uint64 now)
+// initAppState() plus the settings from the command line shared by every mode
+SC_AppState *startAppState(Uint64 now, Uint32 numCharacters)
 {
-    for (int i = 0; i < scAppState->numCharacters; i++) {
-        SC_Character *c = scAppState->characters + i;
-        Uint64 opts = 0;
-
-        int newState = FSMsCharacter[c->state].tick(c, delta, now, &opts);
+    SC_AppState *s = initAppState(now, numCharacters);
+    if (s == NULL) {
+        SDL_Log("Failed to allocate app state");
+        return NULL;
+    }
+    s->dispatchMode = dispatchMode;
+    s->workers = workers;
 
-        if (newState != SC_FSM_NO_CHANGE) {
-            //SDL_Log("Leave %d, Enter %d", c->state, newState);
-            FSMsCharacter[c->state].exit(c, &opts);
-            c->state = newState;
-            FSMsCharacter[c->state].enter(c, &opts);
-        }
+    if (numLevelPaths > 0 && !useLevel(s, 0, now)) {
+        destroyAppState(s);
+        return NULL;
     }
+    if (numArenaEnemies > 0 && !setArenaEnemies(s, numArenaEnemies)) {
+        SDL_Log("Failed to allocate %u enemies", numArenaEnemies);
+        destroyAppState(s);
+        return NULL;
+    }
+    return s;
 }
 
-void destroyAppState(SC_AppState *scAppState)
+// Textures are lost with the render device, so this also runs after a reset
+void loadCharacterSprites()
 {
-    SDL_free(scAppState->characters);
-    scAppState->characters = NULL;
-    SDL_free(scAppState);
-    scAppState = NULL;
-
-    destroyCharacterFSM();
+    char path[1024];
+    SDL_snprintf(path, sizeof(path), "%s%s", SDL_GetBasePath(), ATLAS_PATH);
+    if (!loadAtlas(&atlas, renderer, path)) {
+        SDL_Log("Drawing characters without sprites");
+    }
+    characterBatch.texture = atlas.texture;
 }
 
 SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[])
 {
     SDL_SetAppMetadata("Sewer Cleanup", "1.0.0", "net.faisonz.games.sewer-cleanup");
 
+    if (!parseArgs(argc, argv)) {
+        return SDL_APP_FAILURE;
+    }
+
+    if (benchDispatchEnabled) {
+        benchDispatch();
+        return SDL_APP_SUCCESS;
+    }
+
+    if (benchThreadsEnabled) {
+        benchThreads();
+        return SDL_APP_SUCCESS;
+    }
+
+    if (benchFSMEnabled) {
+        benchFSM();
+        return SDL_APP_SUCCESS;
+    }
+
+    if (compileLevelPaths[0] != NULL) {
+        return compileLevelFile(compileLevelPaths[0], compileLevelPaths[1]) ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+    }
+
+    if (packAtlasPaths[0] != NULL) {
+        return packAtlas(packAtlasPaths[0], packAtlasPaths[1]) ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+    }
+
+    // Sweep instances are independent, so they use every core unless told
+    // otherwise
+    if (sweep.path != NULL && !numThreadsGiven) {
+        numThreads = 0;
+    }
+
+    if (numThreads != 1) {
+        workers = createWorkers(numThreads);
+    }
+
+    if (sweep.path != NULL) {
+        return runSweep(sweep.path, sweep.csvPath, workers) ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+    }
+
+    if (rollback.enabled) {
+        if (numLevelPaths > 0 && !loadLevel(&loadedLevel, levelPaths[0])) {
+            return SDL_APP_FAILURE;
+        }
+        bool ok = rollbackTest(headless.ticksTotal, headless.numCharacters, numLevelPaths > 0 ? &loadedLevel : NULL, dispatchMode, workers);
+        return ok ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+    }
+
+    if (replay.playPath != NULL) {
+        if (!SDL_Init(SDL_INIT_EVENTS)) {
+            SDL_Log("Failed to init events: %s", SDL_GetError());
+            return SDL_APP_FAILURE;
+        }
+        if (!replayLoad()) {
+            return SDL_APP_FAILURE;
+        }
+
+        *appstate = startAppState(0, replay.numCharacters);
+        if (*appstate == NULL) {
+            return SDL_APP_FAILURE;
+        }
+
+        return replayStart(*appstate) ? SDL_APP_CONTINUE : SDL_APP_FAILURE;
+    }
+
+    if (headless.enabled) {
+        if (!SDL_Init(SDL_INIT_EVENTS)) {
+            SDL_Log("Failed to init events: %s", SDL_GetError());
+            return SDL_APP_FAILURE;
+        }
+
+        *appstate = startAppState(SDL_GetTicks(), headless.numCharacters);
+        if (*appstate == NULL) {
+            return SDL_APP_FAILURE;
+        }
+        if (replay.recordPath != NULL && !recordStart(*appstate, REPLAY_FLAG_SCRIPT)) {
+            return SDL_APP_FAILURE;
+        }
+        headlessStart(*appstate);
+
+        return SDL_APP_CONTINUE;
+    }
+
     if (!SDL_Init(SDL_INIT_VIDEO)) {
         SDL_Log("Failed to init video: %s", SDL_GetError());
         return SDL_APP_FAILURE;
@@ -106,67 +342,83 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[])
         return SDL_APP_FAILURE;
     }
 
-    *appstate = initAppState(SDL_GetTicks());
+    createBackground();
+    loadCharacterSprites();
+    createHud(&hud, renderer);
+    pacingStart(renderer);
+
+    *appstate = startAppState(SDL_GetTicks(), 1);
+    if (*appstate == NULL) {
+        return SDL_APP_FAILURE;
+    }
+    ((SC_AppState *) *appstate)->interpolate = true;
+    if (replay.recordPath != NULL && !recordStart(*appstate, 0)) {
+        return SDL_APP_FAILURE;
+    }
 
     return SDL_APP_CONTINUE;
 }
 
-void handleInput(SC_AppState *s, Uint64 event, Uint32 keyFlag, Uint64 now)
+// Every key goes through here. It's queued for tick() to apply, and record,
+// at the step it happened in. Key repeats don't change anything so they
+// aren't queued.
+void queueInput(SC_AppState *s, const SDL_KeyboardEvent *key, Uint64 event, Uint32 keyFlag)
 {
-    if (event == SC_EVENT_KEYDOWN) {
-        if (keyFlag == KEY_RIGHT && (s->keysDown & KEY_RIGHT) == 0) {
-            s->keysDown |= KEY_RIGHT;
-            eventCharacter(s->characters, SC_EVENT_RUN_START, now, CHARACTER_MOVE_RIGHT);
-        } else if (keyFlag == KEY_LEFT && (s->keysDown & KEY_LEFT) == 0) {
-            s->keysDown |= KEY_LEFT;
-            eventCharacter(s->characters, SC_EVENT_RUN_START, now, CHARACTER_MOVE_LEFT);
-        } else if (keyFlag == KEY_JUMP && (s->keysDown & KEY_JUMP) == 0) {
-            s->keysDown |= KEY_JUMP;
-            eventCharacter(s->characters, SC_EVENT_JUMP, now, 0);
-        }
-    } else if (event == SC_EVENT_KEYUP) {
-        if (keyFlag == KEY_RIGHT && (s->keysDown & KEY_RIGHT) > 0) {
-            s->keysDown &= ~KEY_RIGHT;
-            eventCharacter(s->characters, SC_EVENT_RUN_STOP, now, CHARACTER_MOVE_RIGHT);
-        } else if (keyFlag == KEY_LEFT && (s->keysDown & KEY_LEFT) > 0) {
-            s->keysDown &= ~KEY_LEFT;
-            eventCharacter(s->characters, SC_EVENT_RUN_STOP, now, CHARACTER_MOVE_LEFT);
-        } else if (keyFlag == KEY_JUMP && (s->keysDown & KEY_JUMP) > 0) {
-            s->keysDown &= ~KEY_JUMP;
-            eventCharacter(s->characters, SC_EVENT_JUMP_STOP, now, 0);
-        }
+    if (key->repeat) {
+        return;
+    }
+
+    if (!pushInput(&s->input, key->timestamp, (Uint32) event, keyFlag)) {
+        SDL_Log("Input queue full, dropped a key event");
     }
 }
 
 SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event)
 {
     SC_AppState *scAppState = (SC_AppState *) appstate;
-    Uint64 now = SDL_GetTicks();
 
     if (event->type == SDL_EVENT_QUIT) {
         return SDL_APP_SUCCESS;
+    } else if (event->type == SDL_EVENT_RENDER_TARGETS_RESET) {
+        backgroundDirty = true;
+        hudTargetsLost(&hud);
+    } else if (event->type == SDL_EVENT_RENDER_DEVICE_RESET) {
+        createBackground();
+        loadCharacterSprites();
+        createHud(&hud, renderer);
     } else if (event->type == SDL_EVENT_KEY_DOWN) {
         switch (event->key.key) {
+            case SDLK_F1:
+                timing.overlay = !timing.overlay;
+                break;
+            case SDLK_TAB:
+                // A recording has to stay on the level it started on
+                if (replay.out != NULL) {
+                    SDL_Log("Can't change level while recording");
+                } else if (numLevelPaths > 1 && !event->key.repeat) {
+                    useLevel(scAppState, (currentLevel + 1) % numLevelPaths, SDL_GetTicks());
+                }
+                break;
             case SDLK_D:
-                handleInput(scAppState, SC_EVENT_KEYDOWN, KEY_RIGHT, now);
+                queueInput(scAppState, &event->key, SC_EVENT_KEYDOWN, KEY_RIGHT);
                 break;
             case SDLK_A:
-                handleInput(scAppState, SC_EVENT_KEYDOWN, KEY_LEFT, now);
+                queueInput(scAppState, &event->key, SC_EVENT_KEYDOWN, KEY_LEFT);
                 break;
             case SDLK_SPACE:
-                handleInput(scAppState, SC_EVENT_KEYDOWN, KEY_JUMP, now);
+                queueInput(scAppState, &event->key, SC_EVENT_KEYDOWN, KEY_JUMP);
                 break;
         }
     } else if (event->type == SDL_EVENT_KEY_UP) {
         switch (event->key.key) {
             case SDLK_D:
-                handleInput(scAppState, SC_EVENT_KEYUP, KEY_RIGHT, now);
+                queueInput(scAppState, &event->key, SC_EVENT_KEYUP, KEY_RIGHT);
                 break;
             case SDLK_A:
-                handleInput(scAppState, SC_EVENT_KEYUP, KEY_LEFT, now);
+                queueInput(scAppState, &event->key, SC_EVENT_KEYUP, KEY_LEFT);
                 break;
             case SDLK_SPACE:
-                handleInput(scAppState, SC_EVENT_KEYUP, KEY_JUMP, now);
+                queueInput(scAppState, &event->key, SC_EVENT_KEYUP, KEY_JUMP);
                 break;
         }
     }
@@ -174,41 +426,13 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event)
     return SDL_APP_CONTINUE;
 }
 
-void tick(SC_AppState *scAppState, Uint64 now)
+// Body and head of character `i` as flat rects, standing at x, y. The head
+// leans with the character's speed and direction.
+void renderCharacterRects(SC_RenderBatch *b, const SC_Characters *c, Uint32 i, float x, float y)
 {
-    // TICK UPDATE
-    scAppState->msAccum += now - scAppState->prevTick;
-
-    while (scAppState->msAccum >= FIXED_TICK_RATE) {
-        tickCharacters(scAppState, FIXED_TICK_RATE, now);
-
-        scAppState->msAccum -= FIXED_TICK_RATE;
-    }
-
-    scAppState->prevTick = now;
-}
-
-SDL_AppResult SDL_AppIterate(void *appstate)
-{
-    SC_AppState *scAppState = (SC_AppState *) appstate;
-    Uint64 now = SDL_GetTicks();
-
-    tick(scAppState, now);
-
-    // RENDER
-    SDL_SetRenderDrawColor(renderer, 0, 0, 0, SDL_ALPHA_OPAQUE);
-    SDL_RenderClear(renderer);
-
-    SDL_SetRenderDrawColor(renderer, 255, 255, 255, SDL_ALPHA_OPAQUE);
-    SDL_RenderLine(renderer, 0, GROUND_Y, WINDOW_WIDTH, GROUND_Y);
-    SDL_RenderLine(renderer, 0, GROUND_Y - 40.0f, WINDOW_WIDTH, GROUND_Y - 40.0f);
-    SDL_RenderLine(renderer, 0, GROUND_Y - 80.0f, WINDOW_WIDTH, GROUND_Y - 80.0f);
-    SDL_RenderLine(renderer, 0, GROUND_Y - 120.0f, WINDOW_WIDTH, GROUND_Y - 120.0f);
-    SDL_RenderLine(renderer, 0, GROUND_Y - 160.0f, WINDOW_WIDTH, GROUND_Y - 160.0f);
-
     SDL_FRect p = {
-        .x = scAppState->characters->pos.x - 20.0f,
-        .y = scAppState->characters->pos.y - 40.0f,
+        .x = x - 20.0f,
+        .y = y - 40.0f,
         .w = 40.0f,
         .h = 40.0f,
     };
@@ -220,10 +444,9 @@ SDL_AppResult SDL_AppIterate(void *appstate)
         .h = 14.0f,
     };
 
-    SC_Character *c = scAppState->characters;
-    float dir = (c->flags & CHARACTER_FLAG_FACE_RIGHT) > 0 ? 1.0f : -1.0f;
+    float dir = (c->flags[i] & CHARACTER_FLAG_FACE_RIGHT) > 0 ? 1.0f : -1.0f;
     float s = 0.0f;
-    switch (c->state) {
+    switch (c->state[i]) {
         case SC_CHARACTER_STAND:
         case SC_CHARACTER_STAND_JUMP:
         case SC_CHARACTER_STAND_FALL:
@@ -249,7 +472,7 @@ SDL_AppResult SDL_AppIterate(void *appstate)
 
     dir = 1.0f;
     s = 0.0f;
-    switch (c->state) {
+    switch (c->state[i]) {
         case SC_CHARACTER_STAND_JUMP:
         case SC_CHARACTER_RUN_START_JUMP:
         case SC_CHARACTER_RUN_STOP_JUMP:
@@ -265,43 +488,221 @@ SDL_AppResult SDL_AppIterate(void *appstate)
         default:
             break;
     }
-    float absY = SDL_fabsf(c->vel.y);
+    float absY = SDL_fabsf(REAL_TO_FLOAT(c->velY[i]));
+    float maxY = REAL_TO_FLOAT(c->tuning.yVelMax);
     if (absY == 0.0f) {
         s = 0.0f;
-    } else if (absY < 0.2f * PLAYER_Y_VEL_MAX) {
+    } else if (absY < 0.2f * maxY) {
         s = 4.0f;
-    } else if (absY < 0.6f * PLAYER_Y_VEL_MAX) {
+    } else if (absY < 0.6f * maxY) {
         s = 8.0f;
     } else {
         s = 12.0f;
     }
     pH.y += dir * s;
 
-    SDL_SetRenderDrawColor(renderer, 254, 231, 97, SDL_ALPHA_OPAQUE);
-    SDL_RenderFillRect(renderer, &p);
-    SDL_SetRenderDrawColor(renderer, 0, 0, 0, SDL_ALPHA_OPAQUE);
-    SDL_RenderFillRect(renderer, &pH);
-
-    SDL_SetRenderScale(renderer, 3.0f, 3.0f);
-    SDL_SetRenderDrawColor(renderer, 255, 238, 229, SDL_ALPHA_OPAQUE);
-    SDL_RenderDebugTextFormat(renderer, 5.0f, 05.0f, "Left: %s", (scAppState->keysDown & KEY_LEFT) > 0 ? "Down" : "Up");
-    SDL_RenderDebugTextFormat(renderer, 5.0f, 15.0f, "Right: %s", (scAppState->keysDown & KEY_RIGHT) > 0 ? "Down" : "Up");
-    SDL_RenderDebugTextFormat(renderer, 5.0f, 25.0f, "Jump: %s", (scAppState->keysDown & KEY_JUMP) > 0 ? "Down" : "Up");
-    SDL_RenderDebugTextFormat(renderer, 5.0f, 35.0f, "State: %u", scAppState->characters->state);
+    batchRect(b, &p, characterBodyColor);
+    batchRect(b, &pH, characterHeadColor);
+}
+
+// Character `i`, `alpha` of the way from its previous position to its
+// current one, with the sprite for its state and facing
+void renderCharacter(SC_RenderBatch *b, const SC_Characters *c, Uint32 i, float alpha)
+{
+    float prevX = REAL_TO_FLOAT(c->prevX[i]);
+    float prevY = REAL_TO_FLOAT(c->prevY[i]);
+    float x = prevX + (REAL_TO_FLOAT(c->posX[i]) - prevX) * alpha;
+    float y = prevY + (REAL_TO_FLOAT(c->posY[i]) - prevY) * alpha;
+
+    if (b->texture == NULL) {
+        renderCharacterRects(b, c, i, x, y);
+        return;
+    }
+
+    int sprite = SC_SPRITE_CHARACTER(c->state[i], c->flags[i]);
+    SDL_FPoint size = atlas.size[sprite];
+    SDL_FRect dst = { x - size.x * 0.5f, y - size.y, size.x, size.y };
+    batchSprite(b, &dst, &atlas.uv[sprite]);
+}
+
+// Enemy `i` as a flat rect in its kind's color. Flipped enemies lie flat,
+// recovering ones blink and dying ones turn grey.
+void renderEnemy(SC_RenderBatch *b, const SC_Enemies *e, Uint32 i)
+{
+    float x = REAL_TO_FLOAT(e->posX[i]);
+    float y = REAL_TO_FLOAT(e->posY[i]);
+    float w = 32.0f;
+    float h = 32.0f;
+    SDL_FColor color = enemyKindColors[e->kind[i] % SDL_arraysize(enemyKindColors)];
+
+    switch (e->state[i]) {
+        case SC_ENEMY_FLIP:
+            w = 36.0f;
+            h = 16.0f;
+            break;
+        case SC_ENEMY_RECOVER:
+            w = 36.0f;
+            h = 16.0f;
+            if ((e->timer[i] / 8) % 2 == 0) {
+                color = lineColor;
+            }
+            break;
+        case SC_ENEMY_DIE:
+            color = enemyDieColor;
+            break;
+        default:
+            break;
+    }
+
+    SDL_FRect r = { x - w * 0.5f, y - h, w, h };
+    batchRect(b, &r, color);
+}
+
+// Writes the HUD items whose values changed since the last frame
+void updateHud(const SC_AppState *s, Uint8 playerState)
+{
+    Uint32 keys = s->keysDown[0];
+    SC_HudText *items = hud.items;
+
+    if (hudChanged(&items[SC_HUD_LEFT], keys & KEY_LEFT)) {
+        SDL_snprintf(items[SC_HUD_LEFT].text, sizeof(items[SC_HUD_LEFT].text), "Left: %s", (keys & KEY_LEFT) > 0 ? "Down" : "Up");
+    }
+    if (hudChanged(&items[SC_HUD_RIGHT], keys & KEY_RIGHT)) {
+        SDL_snprintf(items[SC_HUD_RIGHT].text, sizeof(items[SC_HUD_RIGHT].text), "Right: %s", (keys & KEY_RIGHT) > 0 ? "Down" : "Up");
+    }
+    if (hudChanged(&items[SC_HUD_JUMP], keys & KEY_JUMP)) {
+        SDL_snprintf(items[SC_HUD_JUMP].text, sizeof(items[SC_HUD_JUMP].text), "Jump: %s", (keys & KEY_JUMP) > 0 ? "Down" : "Up");
+    }
+    if (hudChanged(&items[SC_HUD_STATE], playerState)) {
+        SDL_snprintf(items[SC_HUD_STATE].text, sizeof(items[SC_HUD_STATE].text), "State: %u", playerState);
+    }
+    if (hudChanged(&items[SC_HUD_KICKED_LABEL], 0)) {
+        SDL_strlcpy(items[SC_HUD_KICKED_LABEL].text, "Kicked", sizeof(items[SC_HUD_KICKED_LABEL].text));
+    }
+    if (hudChanged(&items[SC_HUD_ENEMIES_LABEL], 0)) {
+        SDL_strlcpy(items[SC_HUD_ENEMIES_LABEL].text, "Enemies", sizeof(items[SC_HUD_ENEMIES_LABEL].text));
+    }
+    hudCounter(&items[SC_HUD_KICKED], s->enemies.totalKilled);
+    hudCounter(&items[SC_HUD_ENEMIES], s->enemies.count);
+}
+
+// Under the pacing line of the frame timing overlay, as of the last step
+void renderScheduleOverlay(SDL_Renderer *renderer, const SC_Characters *c)
+{
+    if (!timing.overlay) {
+        return;
+    }
+
+    SDL_SetRenderScale(renderer, 2.0f, 2.0f);
+    SDL_SetRenderDrawColor(renderer, 160, 220, 255, SDL_ALPHA_OPAQUE);
+    SDL_RenderDebugTextFormat(renderer, 165.0f, 35.0f + 10.0f * SC_PHASE_TOTAL, "chars %6u active %6u sleeping",
+        c->numActive,
+        c->count - c->numActive);
     SDL_SetRenderScale(renderer, 1.0f, 1.0f);
+}
+
+SDL_AppResult SDL_AppIterate(void *appstate)
+{
+    SC_AppState *scAppState = (SC_AppState *) appstate;
+
+    // Nothing from the last frame's scratch is still in use
+    arenaReset(&scAppState->frame);
+
+    if (replay.playing) {
+        return replayIterate(scAppState);
+    }
+
+    if (headless.enabled) {
+        return headlessIterate(scAppState);
+    }
+
+    Uint64 now = SDL_GetTicks();
+
+    timingBeginFrame();
+
+    tick(scAppState, now);
+    timingMark(SC_PHASE_TICK);
+
+    if (!pacingShouldRender(window)) {
+        pacingEndFrame(scAppState);
+        return SDL_APP_CONTINUE;
+    }
+
+    // RENDER
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, SDL_ALPHA_OPAQUE);
+    SDL_RenderClear(renderer);
+    timingMark(SC_PHASE_CLEAR);
+
+    renderBackground(scAppState->level);
+    timingMark(SC_PHASE_BACKGROUND);
+
+    SC_Characters *c = &scAppState->characters;
+    Uint32 player = 0;
+    characterIndex(c, scAppState->players[0], &player);
+
+    // Enemies aren't interpolated, they move at most a few px per step
+    const SC_Enemies *e = &scAppState->enemies;
+    for (Uint32 i = 0; i < e->count; i++) {
+        renderEnemy(&enemyBatch, e, i);
+    }
+    flushRenderBatch(renderer, &enemyBatch);
+
+    float alpha = renderAlpha(scAppState);
+    for (Uint32 i = 0; i < c->count; i++) {
+        renderCharacter(&characterBatch, c, i, alpha);
+    }
+    flushRenderBatch(renderer, &characterBatch);
+    timingMark(SC_PHASE_CHARACTERS);
+
+    updateHud(scAppState, c->state[player]);
+    renderHud(renderer, &hud);
+    timingRenderOverlay(renderer);
+    pacingRenderOverlay(renderer);
+    renderScheduleOverlay(renderer, c);
+    timingMark(SC_PHASE_TEXT);
 
     SDL_RenderPresent(renderer);
+    timingMark(SC_PHASE_PRESENT);
+    timingEndFrame();
+    pacingEndFrame(scAppState);
 
     return SDL_APP_CONTINUE;
 }
 
 void SDL_AppQuit(void *appstate, SDL_AppResult result)
 {
+    destroyReplay();
+    timingWriteCSV();
+    pacingReport();
+    destroyRenderBatch(&worldBatch);
+    destroyRenderBatch(&characterBatch);
+    destroyRenderBatch(&enemyBatch);
+    destroyAtlas(&atlas);
+    destroyHud(&hud);
+
+    if (background != NULL) {
+        SDL_DestroyTexture(background);
+        background = NULL;
+    }
+
+    if (appstate != NULL) {
+        SC_AppState *scAppState = (SC_AppState *) appstate;
+        logArena(&scAppState->arena);
+        logArena(&scAppState->frame);
+    }
     destroyAppState((SC_AppState *) appstate);
     appstate = NULL;
+    destroyLevel(&loadedLevel);
+
+    destroyWorkers(workers);
+    workers = NULL;
 
-    SDL_DestroyRenderer(renderer);
-    renderer = NULL;
-    SDL_DestroyWindow(window);
-    window = NULL;
+    if (renderer != NULL) {
+        SDL_DestroyRenderer(renderer);
+        renderer = NULL;
+    }
+    if (window != NULL) {
+        SDL_DestroyWindow(window);
+        window = NULL;
+    }
 }
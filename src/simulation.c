@@ -0,0 +1,496 @@
+#include <SDL3/SDL.h>
+#include "types.h"
+#include "fsm.h"
+#include "arena.c"
+#include "fsm-character.c"
+#include "fsm-enemy.c"
+#include "characters.c"
+#include "dispatch.c"
+#include "workers.c"
+#include "level.c"
+#include "motion.c"
+#include "collision.c"
+#include "enemies.c"
+#include "snapshot.c"
+#include "input.c"
+
+#define FIXED_TICK_RATE 16
+
+// Most fixed steps tick() runs per call. After a longer stall the simulation
+// falls behind wall-clock time instead of spending ever longer catching up.
+#define MAX_CATCHUP_TICKS 8
+
+// Fewest characters worth handing to another thread
+#define TICK_GRAIN 1024
+
+#define SC_EVENT_KEYUP   0b0
+#define SC_EVENT_KEYDOWN 0b1
+
+#define KEY_RIGHT 0b0001
+#define KEY_LEFT  0b0010
+#define KEY_JUMP  0b0100
+
+// Puts character `i` back at `spawn`, one of the level's spawn points
+void resetPlayer(SC_Characters *c, Uint32 i, const SC_Level *level, const SC_SpawnPoint *spawn)
+{
+    c->posX[i] = REAL_FROM_INT(spawn->x);
+    c->posY[i] = REAL_FROM_INT(spawn->y);
+    c->velX[i] = 0;
+    c->velY[i] = 0;
+    c->accX[i] = 0;
+    c->accY[i] = 0;
+    c->prevX[i] = c->posX[i];
+    c->prevY[i] = c->posY[i];
+    c->floorY[i] = level->groundY;
+    c->flags[i] = CHARACTER_FLAG_FACE_RIGHT;
+    c->state[i] = SC_CHARACTER_STAND;
+    c->wakeIn[i] = 0;
+    wakeCharacter(c, i);
+}
+
+void resetAppState(SC_AppState *scAppState, Uint64 now)
+{
+    scAppState->prevTick = now;
+    scAppState->tickCount = 0;
+    scAppState->activeTicks = 0;
+    scAppState->sleepingTicks = 0;
+    SDL_zeroa(scAppState->keysDown);
+
+    // The pool already has room for every starting character, so this
+    // reuses its memory rather than allocating. Characters are dealt out to
+    // the level's spawn points in turn, starting with the player.
+    SC_Characters *c = &scAppState->characters;
+    const SC_Level *level = scAppState->level;
+    clearCharacters(c);
+    clearEnemies(&scAppState->enemies);
+    for (Uint32 p = 0; p < SC_MAX_PLAYERS; p++) {
+        scAppState->players[p] = SC_HANDLE_NONE;
+    }
+
+    for (Uint32 n = 0; n < scAppState->numStartCharacters; n++) {
+        SC_Handle h = spawnCharacter(c);
+        Uint32 i;
+        if (!characterIndex(c, h, &i)) {
+            break;
+        }
+        resetPlayer(c, i, level, &level->spawns[n % level->numSpawns]);
+
+        if (n < scAppState->numPlayers) {
+            scAppState->players[n] = h;
+        }
+    }
+}
+
+// Used until another level is set with setLevel()
+static SC_Level defaultLevel;
+
+// The character FSM table and default level are shared by every app state
+// and freed with the last one
+static Uint32 numAppStates = 0;
+
+// Everything initAppState allocates, so a state whose pools never grow
+// fits in the arena's first chunk. Each allocation is rounded up to
+// SC_ARENA_ALIGN, hence the slack.
+static size_t appStateArenaSize(Uint32 numCharacters)
+{
+    return sizeof(SC_AppState)
+        + layoutCharacters(NULL, NULL, numCharacters)
+        + numCharacters * (2 * sizeof(Uint32) + sizeof(Uint8))  // Dispatch
+        + numCharacters * (2 * sizeof(Uint32) + sizeof(Uint16)) // Collisions
+        + layoutEnemies(NULL, NULL, ENEMY_DEFAULT_CAPACITY)
+        + 8 * SC_ARENA_ALIGN;
+}
+
+// One step's scratch: batched dispatch transitions, the two lists
+// rescheduleCharacters merges into and player contacts
+static size_t frameArenaSize(Uint32 numCharacters)
+{
+    return numCharacters * (sizeof(SC_Transition) + 2 * sizeof(Uint32) + SC_MAX_PLAYERS * sizeof(SC_Contact)) + 3 * SC_ARENA_ALIGN;
+}
+
+// The state lives in its own arena, so that goes last
+static void freeAppState(SC_AppState *scAppState)
+{
+    SC_Arena arena = scAppState->arena;
+    destroyArena(&scAppState->frame);
+    destroyArena(&arena);
+}
+
+SC_AppState* initAppState(Uint64 now, Uint32 numCharacters)
+{
+    if (FSMsCharacter == NULL) {
+        initCharacterFSM();
+    }
+    selectIntegrateKernel();
+
+    if (numCharacters == 0) {
+        numCharacters = 1;
+    }
+
+    SC_Arena arena;
+    if (!initArena(&arena, "state", appStateArenaSize(numCharacters))) {
+        return NULL;
+    }
+    SC_AppState *scAppState = arenaAlloc(&arena, sizeof(SC_AppState));
+    SDL_zerop(scAppState);
+    scAppState->arena = arena;
+    if (!initArena(&scAppState->frame, "frame", frameArenaSize(numCharacters))) {
+        freeAppState(scAppState);
+        return NULL;
+    }
+
+    scAppState->dispatchMode = SC_DISPATCH_DIRECT;
+    initInputQueue(&scAppState->input);
+    scAppState->numStartCharacters = numCharacters;
+    scAppState->numPlayers = 1;
+    if (defaultLevel.data == NULL && !initDefaultLevel(&defaultLevel)) {
+        freeAppState(scAppState);
+        return NULL;
+    }
+    scAppState->level = &defaultLevel;
+
+    // Pools keep a pointer to the arena, so it has to be the one in the state
+    SC_Arena *a = &scAppState->arena;
+    if (!initCharacters(&scAppState->characters, a, numCharacters)
+        || !initDispatch(&scAppState->dispatch, a, numCharacters)
+        || !initCollisions(&scAppState->collisions, a, numCharacters)
+        || !initEnemies(&scAppState->enemies, a, ENEMY_DEFAULT_CAPACITY)) {
+        freeAppState(scAppState);
+        return NULL;
+    }
+    numAppStates++;
+    resetAppState(scAppState, now);
+    return scAppState;
+}
+
+// Switches to `level` and starts over on it. `level` has to outlive its use
+// here; NULL goes back to the built-in level.
+void setLevel(SC_AppState *scAppState, const SC_Level *level, Uint64 now)
+{
+    scAppState->level = level != NULL ? level : &defaultLevel;
+    resetAppState(scAppState, now);
+}
+
+void eventCharacter(SC_Characters *c, Uint32 i, SC_Event e, Uint64 now, Uint64 opts)
+{
+    int newMoveState = characterInput(c, i, e, &opts);
+
+    if (newMoveState != SC_FSM_NO_CHANGE) {
+        //SDL_Log("Leave %d, Enter %d", c->state[i], newMoveState);
+        characterTransition(c, i, newMoveState, &opts);
+        c->wakeIn[i] = 0;
+        wakeCharacter(c, i);
+    }
+}
+
+
+typedef struct SC_TickJob {
+    SC_Characters *c;
+    const SC_Level *level;
+    Uint64 delta;
+    Uint64 now;
+    bool predicted;
+} SC_TickJob;
+
+static void tickCharacterRange(SC_TickJob *job, Uint32 begin, Uint32 end)
+{
+    if (job->predicted) {
+        tickCharactersPredicted(job->c, job->level, begin, end, (Uint32) job->delta);
+        return;
+    }
+
+    computeFloors(job->c, job->level, begin, end);
+    integrateCharacters(job->c, begin, end, (Uint32) job->delta, job->c->tuning.xVelMax, job->c->tuning.yVelMax);
+    tickCharactersDirect(job->c, begin, end, job->delta, job->now);
+}
+
+// Characters at rest are put to sleep this often. Until then they're ticked
+// for nothing.
+#define SCHEDULE_SLEEP_TICKS 8
+
+// Sleeping characters have nothing to do, so ticking one changes nothing.
+// Gaps of up to this many of them are ticked through rather than splitting a
+// run.
+#define SCHEDULE_MAX_GAP 16
+
+// Ticks the active characters stored at [begin, end). Each character's
+// tick only touches its own slots in the arrays, so chunks can run on any
+// thread in any order and give the same result. Chunks split storage rather
+// than the active list so their boundaries stay on the workers' alignment.
+// Runs of neighbouring characters go through the range functions together.
+static void tickCharactersJob(void *data, Uint32 begin, Uint32 end)
+{
+    SC_TickJob *job = data;
+    const SC_Characters *c = job->c;
+    const Uint32 *s = c->schedule;
+    Uint32 n = c->numActive;
+
+    // The active list is in storage order, see rescheduleCharacters
+    Uint32 p = 0;
+    for (Uint32 hi = n; p < hi;) {
+        Uint32 mid = p + (hi - p) / 2;
+        if (s[mid] < begin) {
+            p = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    while (p < n && s[p] < end) {
+        Uint32 first = s[p++];
+        Uint32 last = first + 1;
+        while (p < n && s[p] < end && s[p] - last <= SCHEDULE_MAX_GAP) {
+            last = s[p++] + 1;
+        }
+        tickCharacterRange(job, first, last);
+    }
+}
+
+// Standing still on its floor with nothing accelerating it, a character's
+// tick does nothing until something from outside changes it
+static bool characterIdle(SC_Characters *c, const SC_Level *level, Uint32 i)
+{
+    if (c->state[i] != SC_CHARACTER_STAND
+        || c->velX[i] != 0 || c->velY[i] != 0
+        || c->accX[i] != 0 || c->accY[i] != 0) {
+        return false;
+    }
+
+    // The floor this tick came from where the character was before moving
+    computeFloors(c, level, i, i + 1);
+    return c->posY[i] >= c->floorY[i];
+}
+
+static int compareIndices(const void *a, const void *b)
+{
+    Uint32 x = *(const Uint32 *) a;
+    Uint32 y = *(const Uint32 *) b;
+    return (x > y) - (x < y);
+}
+
+// Merges the characters woken since the last tick into the active list and,
+// if `sleep` is set, puts the ones at rest to sleep, all in one pass.
+// Keeping the list in storage order lets ticks walk memory forwards, in runs
+// as long as possible.
+static void rescheduleCharacters(SC_Characters *c, const SC_Level *level, SC_Arena *scratch, bool sleep)
+{
+    Uint32 *s = c->schedule;
+    Uint32 n = c->numActive;
+    Uint32 sorted = c->numSorted;
+
+    if (sorted == n && !sleep) {
+        return;
+    }
+    SDL_qsort(s + sorted, n - sorted, sizeof(Uint32), compareIndices);
+
+    // Everything before the first woken or resting character stays where it is
+    Uint32 first = sorted;
+    if (sorted < n) {
+        Uint32 lo = 0;
+        while (lo < first) {
+            Uint32 mid = lo + (first - lo) / 2;
+            if (s[mid] < s[sorted]) {
+                lo = mid + 1;
+            } else {
+                first = mid;
+            }
+        }
+    }
+    if (sleep) {
+        Uint32 p = 0;
+        while (p < first && !characterIdle(c, level, s[p])) {
+            p++;
+        }
+        first = p;
+    }
+    if (first == n) {
+        return;
+    }
+
+    // Given back before returning, so both passes in a step share the room
+    // frameArenaSize makes for them
+    SC_ArenaMark mark = arenaMark(scratch);
+    Uint32 *active = arenaAlloc(scratch, (n - first) * sizeof(Uint32));
+    Uint32 *idle = arenaAlloc(scratch, (n - first) * sizeof(Uint32));
+    if (active == NULL || idle == NULL) {
+        // Ticks need the list sorted, nobody sleeps this time
+        SDL_qsort(s + first, n - first, sizeof(Uint32), compareIndices);
+        for (Uint32 p = first; p < n; p++) {
+            c->scheduledAt[s[p]] = p;
+        }
+        c->numSorted = n;
+        arenaRewind(scratch, mark);
+        return;
+    }
+
+    Uint32 numKept = 0;
+    Uint32 numIdle = 0;
+    for (Uint32 a = first, b = sorted; a < sorted || b < n;) {
+        Uint32 i = b >= n || (a < sorted && s[a] < s[b]) ? s[a++] : s[b++];
+        if (sleep && characterIdle(c, level, i)) {
+            idle[numIdle++] = i;
+        } else {
+            active[numKept++] = i;
+        }
+    }
+
+    SDL_memcpy(s + first, active, numKept * sizeof(Uint32));
+    SDL_memcpy(s + first + numKept, idle, numIdle * sizeof(Uint32));
+    for (Uint32 p = first; p < n; p++) {
+        c->scheduledAt[s[p]] = p;
+    }
+    c->numActive = first + numKept;
+    c->numSorted = c->numActive;
+    arenaRewind(scratch, mark);
+}
+
+void tickCharacters(SC_AppState *scAppState, Uint64 delta, Uint64 now)
+{
+    SC_Characters *c = &scAppState->characters;
+
+    scAppState->activeTicks += c->numActive;
+    scAppState->sleepingTicks += c->count - c->numActive;
+
+    // Batches are grouped over every character, so nobody sleeps
+    if (scAppState->dispatchMode == SC_DISPATCH_BATCH) {
+        computeFloors(c, scAppState->level, 0, c->count);
+        integrateCharacters(c, 0, c->count, (Uint32) delta, c->tuning.xVelMax, c->tuning.yVelMax);
+        tickCharactersBatched(c, &scAppState->dispatch, &scAppState->frame, delta, now);
+        return;
+    }
+
+    rescheduleCharacters(c, scAppState->level, &scAppState->frame, false);
+
+    SC_TickJob job = {
+        .c = c,
+        .level = scAppState->level,
+        .delta = delta,
+        .now = now,
+        .predicted = scAppState->dispatchMode == SC_DISPATCH_PREDICTED,
+    };
+    runWorkers(scAppState->workers, tickCharactersJob, &job, c->count, TICK_GRAIN);
+    if (scAppState->tickCount % SCHEDULE_SLEEP_TICKS == 0) {
+        rescheduleCharacters(c, scAppState->level, &scAppState->frame, true);
+    }
+}
+
+void destroyAppState(SC_AppState *scAppState)
+{
+    if (scAppState == NULL) {
+        return;
+    }
+
+    freeAppState(scAppState);
+
+    if (--numAppStates == 0) {
+        destroyCharacterFSM();
+        destroyLevel(&defaultLevel);
+    }
+}
+
+// A key going down or up for player `p`
+void handleInput(SC_AppState *s, Uint32 p, Uint64 event, Uint32 keyFlag, Uint64 now)
+{
+    Uint32 player;
+    if (p >= s->numPlayers || !characterIndex(&s->characters, s->players[p], &player)) {
+        return;
+    }
+
+    Uint32 *keysDown = &s->keysDown[p];
+
+    if (event == SC_EVENT_KEYDOWN) {
+        if (keyFlag == KEY_RIGHT && (*keysDown & KEY_RIGHT) == 0) {
+            *keysDown |= KEY_RIGHT;
+            eventCharacter(&s->characters, player, SC_EVENT_RUN_START, now, CHARACTER_MOVE_RIGHT);
+        } else if (keyFlag == KEY_LEFT && (*keysDown & KEY_LEFT) == 0) {
+            *keysDown |= KEY_LEFT;
+            eventCharacter(&s->characters, player, SC_EVENT_RUN_START, now, CHARACTER_MOVE_LEFT);
+        } else if (keyFlag == KEY_JUMP && (*keysDown & KEY_JUMP) == 0) {
+            *keysDown |= KEY_JUMP;
+            eventCharacter(&s->characters, player, SC_EVENT_JUMP, now, 0);
+        }
+    } else if (event == SC_EVENT_KEYUP) {
+        if (keyFlag == KEY_RIGHT && (*keysDown & KEY_RIGHT) > 0) {
+            *keysDown &= ~KEY_RIGHT;
+            eventCharacter(&s->characters, player, SC_EVENT_RUN_STOP, now, CHARACTER_MOVE_RIGHT);
+        } else if (keyFlag == KEY_LEFT && (*keysDown & KEY_LEFT) > 0) {
+            *keysDown &= ~KEY_LEFT;
+            eventCharacter(&s->characters, player, SC_EVENT_RUN_STOP, now, CHARACTER_MOVE_LEFT);
+        } else if (keyFlag == KEY_JUMP && (*keysDown & KEY_JUMP) > 0) {
+            *keysDown &= ~KEY_JUMP;
+            eventCharacter(&s->characters, player, SC_EVENT_JUMP_STOP, now, 0);
+        }
+    }
+}
+
+// Advances the simulation by exactly one fixed tick. Its scratch memory is
+// given back at the end, as a frame can run many steps.
+void stepSimulation(SC_AppState *scAppState, Uint64 now)
+{
+    SC_ArenaMark scratch = arenaMark(&scAppState->frame);
+
+    spawnEnemies(scAppState);
+    tickCharacters(scAppState, FIXED_TICK_RATE, now);
+    tickEnemies(scAppState, FIXED_TICK_RATE);
+    collideCharacters(scAppState);
+    collideEnemies(scAppState);
+    scAppState->tickCount++;
+
+    scAppState->collisions.contacts = NULL;
+    arenaRewind(&scAppState->frame, scratch);
+
+    if (scAppState->onStep != NULL) {
+        scAppState->onStep(scAppState, scAppState->onStepData);
+    }
+}
+
+// Applies the queued inputs that happened by `stepTime`, the time the next
+// fixed step ends at, each with its own timestamp
+static void applyQueuedInput(SC_AppState *s, Uint64 stepTime)
+{
+    SC_InputEvent e;
+
+    while (popInputUntil(&s->input, SDL_MS_TO_NS(stepTime), &e)) {
+        if (s->onInput != NULL) {
+            s->onInput(e.event, e.keyFlag);
+        }
+        handleInput(s, 0, e.event, e.keyFlag, SDL_NS_TO_MS(e.timestamp));
+    }
+}
+
+// Runs the fixed steps that fit into the time since the last call. Whatever
+// is left over stays in msAccum, and renderAlpha() turns it into how far
+// rendering is between the last two steps.
+void tick(SC_AppState *scAppState, Uint64 now)
+{
+    // TICK UPDATE
+    scAppState->msAccum += now - scAppState->prevTick;
+
+    Uint64 steps = scAppState->msAccum / FIXED_TICK_RATE;
+    if (steps > MAX_CATCHUP_TICKS) {
+        Uint64 dropped = (steps - MAX_CATCHUP_TICKS) * FIXED_TICK_RATE;
+        SDL_Log("Simulation fell behind, skipping %" SDL_PRIu64 " ms", dropped);
+        scAppState->msAccum -= dropped;
+        steps = MAX_CATCHUP_TICKS;
+    }
+
+    for (Uint64 n = 0; n < steps; n++) {
+        if (scAppState->interpolate && n == steps - 1) {
+            storePreviousPositions(&scAppState->characters);
+        }
+
+        // Each step gets the time its fixed tick ended at, not the frame's,
+        // and the inputs from its span of time
+        scAppState->msAccum -= FIXED_TICK_RATE;
+        applyQueuedInput(scAppState, now - scAppState->msAccum);
+        stepSimulation(scAppState, now - scAppState->msAccum);
+    }
+
+    scAppState->prevTick = now;
+}
+
+// Fraction of a fixed step that has passed since the last one, 0 to 1
+float renderAlpha(const SC_AppState *scAppState)
+{
+    return (float) scAppState->msAccum / (float) FIXED_TICK_RATE;
+}
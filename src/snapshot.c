@@ -0,0 +1,340 @@
+#include <SDL3/SDL.h>
+#include "types.h"
+
+// Snapshots copy the deterministic simulation state of an SC_AppState into a
+// flat buffer and back. Wall-clock bookkeeping (prevTick) and configuration
+// (dispatch mode, workers) are left out. Values are stored in native byte
+// order, so a snapshot only restores on the same kind of machine.
+
+#define SC_SNAPSHOT_HEADER_SIZE (4 * sizeof(Uint64) + SC_MAX_PLAYERS * (sizeof(SC_Handle) + sizeof(Uint32)) + 12 * sizeof(Uint32))
+
+static size_t snapshotSizeFor(Uint32 count, Uint32 numSlots, Uint32 numEnemies)
+{
+    size_t perCharacter = 6 * sizeof(SC_Real) + 2 * sizeof(Uint8) + sizeof(Uint32);
+    size_t perSlot = 2 * sizeof(Uint32);
+    // floorY is left out, every tick works it out again before using it
+    size_t perEnemy = 5 * sizeof(SC_Real) + sizeof(Uint16) + 3 * sizeof(Uint8);
+
+    return SC_SNAPSHOT_HEADER_SIZE + count * perCharacter + numSlots * perSlot + numEnemies * perEnemy;
+}
+
+size_t snapshotSize(const SC_AppState *s)
+{
+    return snapshotSizeFor(s->characters.count, s->characters.numSlots, s->enemies.count);
+}
+
+static Uint8 *snapshotPut(Uint8 *p, const void *src, size_t n)
+{
+    SDL_memcpy(p, src, n);
+    return p + n;
+}
+
+static const Uint8 *snapshotGet(const Uint8 *p, void *dst, size_t n)
+{
+    SDL_memcpy(dst, p, n);
+    return p + n;
+}
+
+// Returns the number of bytes written, or 0 if `size` is too small
+size_t saveSnapshot(const SC_AppState *s, void *buf, size_t size)
+{
+    const SC_Characters *c = &s->characters;
+    const SC_Enemies *e = &s->enemies;
+    size_t needed = snapshotSize(s);
+
+    if (size < needed) {
+        return 0;
+    }
+
+    Uint8 *p = buf;
+    p = snapshotPut(p, &s->tickCount, sizeof(Uint64));
+    p = snapshotPut(p, &s->msAccum, sizeof(Uint64));
+    p = snapshotPut(p, s->players, sizeof(s->players));
+    p = snapshotPut(p, &s->numStartCharacters, sizeof(Uint32));
+    p = snapshotPut(p, &s->numPlayers, sizeof(Uint32));
+    p = snapshotPut(p, s->keysDown, sizeof(s->keysDown));
+    p = snapshotPut(p, &c->count, sizeof(Uint32));
+    p = snapshotPut(p, &c->numSlots, sizeof(Uint32));
+    p = snapshotPut(p, &c->freeSlot, sizeof(Uint32));
+    p = snapshotPut(p, &c->freeSlot, sizeof(Uint32)); // Padding keeps the arrays 8-byte aligned
+    p = snapshotPut(p, &e->count, sizeof(Uint32));
+    p = snapshotPut(p, &e->nextScheduled, sizeof(Uint32));
+    p = snapshotPut(p, &e->numSpawned, sizeof(Uint32));
+    p = snapshotPut(p, &e->dropped, sizeof(Uint32));
+    p = snapshotPut(p, &s->numArenaEnemies, sizeof(Uint32));
+    p = snapshotPut(p, &e->count, sizeof(Uint32)); // Padding
+    p = snapshotPut(p, &e->totalFlipped, sizeof(Uint64));
+    p = snapshotPut(p, &e->totalKilled, sizeof(Uint64));
+
+    p = snapshotPut(p, c->posX, c->count * sizeof(SC_Real));
+    p = snapshotPut(p, c->posY, c->count * sizeof(SC_Real));
+    p = snapshotPut(p, c->velX, c->count * sizeof(SC_Real));
+    p = snapshotPut(p, c->velY, c->count * sizeof(SC_Real));
+    p = snapshotPut(p, c->accX, c->count * sizeof(SC_Real));
+    p = snapshotPut(p, c->accY, c->count * sizeof(SC_Real));
+    p = snapshotPut(p, c->denseSlot, c->count * sizeof(Uint32));
+    p = snapshotPut(p, c->slotDense, c->numSlots * sizeof(Uint32));
+    p = snapshotPut(p, c->slotGen, c->numSlots * sizeof(Uint32));
+    p = snapshotPut(p, c->state, c->count);
+    p = snapshotPut(p, c->flags, c->count);
+
+    p = snapshotPut(p, e->posX, e->count * sizeof(SC_Real));
+    p = snapshotPut(p, e->posY, e->count * sizeof(SC_Real));
+    p = snapshotPut(p, e->velX, e->count * sizeof(SC_Real));
+    p = snapshotPut(p, e->velY, e->count * sizeof(SC_Real));
+    p = snapshotPut(p, e->speed, e->count * sizeof(SC_Real));
+    p = snapshotPut(p, e->timer, e->count * sizeof(Uint16));
+    p = snapshotPut(p, e->state, e->count);
+    p = snapshotPut(p, e->kind, e->count);
+    p = snapshotPut(p, e->flags, e->count);
+
+    return needed;
+}
+
+// Arrays in the buffer may not be aligned
+static Uint32 snapshotWord(const Uint8 *p, Uint32 n)
+{
+    Uint32 w;
+    SDL_memcpy(&w, p + n * sizeof(Uint32), sizeof(w));
+    return w;
+}
+
+// Checks every index the simulation follows without checking, `p` points
+// at the character arrays. Each live character has its own slot, the free
+// slots are chained through the rest, and players are live or stale.
+static bool snapshotCharactersValid(const Uint8 *p, Uint32 count, Uint32 numSlots, Uint32 freeSlot,
+                                    const SC_Handle *players, Uint32 numPlayers)
+{
+    const Uint8 *denseSlot = p + 6 * count * sizeof(SC_Real);
+    const Uint8 *slotDense = denseSlot + count * sizeof(Uint32);
+    const Uint8 *slotGen = slotDense + numSlots * sizeof(Uint32);
+    const Uint8 *state = slotGen + numSlots * sizeof(Uint32);
+
+    for (Uint32 i = 0; i < count; i++) {
+        Uint32 slot = snapshotWord(denseSlot, i);
+        if (slot >= numSlots || snapshotWord(slotDense, slot) != i || state[i] >= SC_CHARACTER_MOVE_STATE_TOTAL) {
+            return false;
+        }
+    }
+
+    // A chain that repeats a slot never gets to the end
+    Uint32 link = freeSlot;
+    for (Uint32 n = count; n < numSlots; n++) {
+        if (link >= numSlots) {
+            return false;
+        }
+        Uint32 next = snapshotWord(slotDense, link);
+        if (next < count && snapshotWord(denseSlot, next) == link) {
+            return false;
+        }
+        link = next;
+    }
+    if (link != SC_SLOT_NONE) {
+        return false;
+    }
+
+    for (Uint32 n = 0; n < numPlayers; n++) {
+        Uint32 slot = (Uint32) players[n];
+        if (slot >= numSlots || snapshotWord(slotGen, slot) != (Uint32) (players[n] >> 32)) {
+            continue;
+        }
+        Uint32 i = snapshotWord(slotDense, slot);
+        if (i >= count || snapshotWord(denseSlot, i) != slot) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Only allocates when the snapshot holds more characters or enemies than the
+// pools have room for. Leaves `s` untouched if the snapshot is malformed.
+bool loadSnapshot(SC_AppState *s, const void *buf, size_t size)
+{
+    SC_Characters *c = &s->characters;
+    SC_Enemies *e = &s->enemies;
+    Uint64 tickCount;
+    Uint64 msAccum;
+    SC_Handle players[SC_MAX_PLAYERS];
+    Uint32 numStartCharacters;
+    Uint32 numPlayers;
+    Uint32 keysDown[SC_MAX_PLAYERS];
+    Uint32 count;
+    Uint32 numSlots;
+    Uint32 freeSlot;
+    Uint32 numEnemies;
+    Uint32 nextScheduled;
+    Uint32 numSpawned;
+    Uint32 dropped;
+    Uint32 numArenaEnemies;
+    Uint64 totalFlipped;
+    Uint64 totalKilled;
+
+    if (size < SC_SNAPSHOT_HEADER_SIZE) {
+        return false;
+    }
+
+    const Uint8 *p = buf;
+    p = snapshotGet(p, &tickCount, sizeof(Uint64));
+    p = snapshotGet(p, &msAccum, sizeof(Uint64));
+    p = snapshotGet(p, players, sizeof(players));
+    p = snapshotGet(p, &numStartCharacters, sizeof(Uint32));
+    p = snapshotGet(p, &numPlayers, sizeof(Uint32));
+    p = snapshotGet(p, keysDown, sizeof(keysDown));
+    p = snapshotGet(p, &count, sizeof(Uint32));
+    p = snapshotGet(p, &numSlots, sizeof(Uint32));
+    p = snapshotGet(p, &freeSlot, sizeof(Uint32));
+    p += sizeof(Uint32);
+    p = snapshotGet(p, &numEnemies, sizeof(Uint32));
+    p = snapshotGet(p, &nextScheduled, sizeof(Uint32));
+    p = snapshotGet(p, &numSpawned, sizeof(Uint32));
+    p = snapshotGet(p, &dropped, sizeof(Uint32));
+    p = snapshotGet(p, &numArenaEnemies, sizeof(Uint32));
+    p += sizeof(Uint32);
+    p = snapshotGet(p, &totalFlipped, sizeof(Uint64));
+    p = snapshotGet(p, &totalKilled, sizeof(Uint64));
+
+    if (count > numSlots || numPlayers > SC_MAX_PLAYERS || nextScheduled > s->level->numScheduled
+        || size < snapshotSizeFor(count, numSlots, numEnemies)
+        || !snapshotCharactersValid(p, count, numSlots, freeSlot, players, numPlayers)) {
+        return false;
+    }
+
+    const Uint8 *enemyState = p + snapshotSizeFor(count, numSlots, 0) - SC_SNAPSHOT_HEADER_SIZE
+                              + numEnemies * (5 * sizeof(SC_Real) + sizeof(Uint16));
+    for (Uint32 i = 0; i < numEnemies; i++) {
+        if (enemyState[i] >= SC_ENEMY_STATE_TOTAL) {
+            return false;
+        }
+    }
+
+    // Room for the same enemies setArenaEnemies makes room for, spawns
+    // dropped with the pool full have to be dropped again
+    if (!reserveCharacters(c, numSlots) || !reserveEnemies(e, SDL_max(numEnemies, numArenaEnemies + s->level->numScheduled))) {
+        return false;
+    }
+
+    s->tickCount = tickCount;
+    s->msAccum = msAccum;
+    s->numStartCharacters = numStartCharacters;
+    s->numPlayers = numPlayers;
+    SDL_memcpy(s->players, players, sizeof(players));
+    SDL_memcpy(s->keysDown, keysDown, sizeof(keysDown));
+    c->count = count;
+    c->numSlots = numSlots;
+    c->freeSlot = freeSlot;
+
+    p = snapshotGet(p, c->posX, count * sizeof(SC_Real));
+    p = snapshotGet(p, c->posY, count * sizeof(SC_Real));
+    p = snapshotGet(p, c->velX, count * sizeof(SC_Real));
+    p = snapshotGet(p, c->velY, count * sizeof(SC_Real));
+    p = snapshotGet(p, c->accX, count * sizeof(SC_Real));
+    p = snapshotGet(p, c->accY, count * sizeof(SC_Real));
+    p = snapshotGet(p, c->denseSlot, count * sizeof(Uint32));
+    p = snapshotGet(p, c->slotDense, numSlots * sizeof(Uint32));
+    p = snapshotGet(p, c->slotGen, numSlots * sizeof(Uint32));
+    p = snapshotGet(p, c->state, count);
+    p = snapshotGet(p, c->flags, count);
+    // Everyone is active and checked again on the next tick
+    SDL_memset(c->wakeIn, 0, count * sizeof(Uint16));
+    wakeAllCharacters(c);
+
+    e->count = numEnemies;
+    e->nextScheduled = nextScheduled;
+    e->numSpawned = numSpawned;
+    e->dropped = dropped;
+    e->totalFlipped = totalFlipped;
+    e->totalKilled = totalKilled;
+    s->numArenaEnemies = numArenaEnemies;
+
+    p = snapshotGet(p, e->posX, numEnemies * sizeof(SC_Real));
+    p = snapshotGet(p, e->posY, numEnemies * sizeof(SC_Real));
+    p = snapshotGet(p, e->velX, numEnemies * sizeof(SC_Real));
+    p = snapshotGet(p, e->velY, numEnemies * sizeof(SC_Real));
+    p = snapshotGet(p, e->speed, numEnemies * sizeof(SC_Real));
+    p = snapshotGet(p, e->timer, numEnemies * sizeof(Uint16));
+    p = snapshotGet(p, e->state, numEnemies);
+    p = snapshotGet(p, e->kind, numEnemies);
+    p = snapshotGet(p, e->flags, numEnemies);
+
+    // Nothing to interpolate from after a jump in time
+    storePreviousPositions(c);
+
+    // The batch dispatch grouping no longer matches, rebuild it next tick
+    s->dispatch.count = SC_SLOT_NONE;
+    s->collisions.count = SC_SLOT_NONE;
+
+    return true;
+}
+
+typedef struct SC_Checksum {
+    Uint64 a;
+    Uint64 b;
+} SC_Checksum;
+
+// Fletcher-style running sums. Replays check every tick, and SDL_crc32 over
+// 100k characters costs far more than ticking them. This is order sensitive
+// enough to catch divergence, not meant to resist tampering.
+static void checksumWords(SC_Checksum *sum, const Uint32 *w, size_t n)
+{
+    Uint64 a = sum->a;
+    Uint64 b = sum->b;
+
+    for (size_t i = 0; i < n; i++) {
+        a += w[i];
+        b += a;
+    }
+
+    sum->a = a;
+    sum->b = b;
+}
+
+static void checksumBytes(SC_Checksum *sum, const Uint8 *bytes, size_t n)
+{
+    Uint64 a = sum->a;
+    Uint64 b = sum->b;
+
+    for (size_t i = 0; i < n; i++) {
+        a += bytes[i];
+        b += a;
+    }
+
+    sum->a = a;
+    sum->b = b;
+}
+
+// Covers everything a replay has to reproduce. The accumulator is left out
+// since replays step one fixed tick at a time.
+Uint32 checksumAppState(const SC_AppState *s)
+{
+    const SC_Characters *c = &s->characters;
+    const SC_Enemies *e = &s->enemies;
+    SC_Checksum sum = { 1, 0 };
+
+    // SC_Real arrays are summed by their bit patterns
+    checksumWords(&sum, (const Uint32 *) c->posX, c->count);
+    checksumWords(&sum, (const Uint32 *) c->posY, c->count);
+    checksumWords(&sum, (const Uint32 *) c->velX, c->count);
+    checksumWords(&sum, (const Uint32 *) c->velY, c->count);
+    checksumWords(&sum, (const Uint32 *) c->accX, c->count);
+    checksumWords(&sum, (const Uint32 *) c->accY, c->count);
+    checksumBytes(&sum, c->state, c->count);
+    checksumBytes(&sum, c->flags, c->count);
+    checksumWords(&sum, (const Uint32 *) &s->tickCount, 2);
+    checksumWords(&sum, s->keysDown, s->numPlayers);
+
+    checksumWords(&sum, (const Uint32 *) e->posX, e->count);
+    checksumWords(&sum, (const Uint32 *) e->posY, e->count);
+    checksumWords(&sum, (const Uint32 *) e->velX, e->count);
+    checksumWords(&sum, (const Uint32 *) e->velY, e->count);
+    checksumWords(&sum, (const Uint32 *) e->speed, e->count);
+    checksumBytes(&sum, (const Uint8 *) e->timer, e->count * sizeof(Uint16));
+    checksumBytes(&sum, e->state, e->count);
+    checksumBytes(&sum, e->kind, e->count);
+    checksumBytes(&sum, e->flags, e->count);
+    checksumWords(&sum, &e->count, 1);
+    checksumWords(&sum, &e->numSpawned, 1);
+
+    Uint64 h = sum.a ^ (sum.b * 0x9E3779B97F4A7C15);
+    return (Uint32) (h ^ (h >> 32));
+}
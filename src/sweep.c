@@ -0,0 +1,534 @@
+#include <SDL3/SDL.h>
+#include "types.h"
+
+// --sweep runs the same few moves under every combination of movement
+// constants listed in a sweep file and reports how each one feels in
+// numbers: how high and how long a jump is, how far a run takes to reach
+// full speed. Each configuration is an independent instance, a character
+// for each SC_SweepMove move, and instances are spread over every core.
+//
+// Instances stand on flat ground with no platforms, and go through the same
+// integration and FSM tick as the game. Up to SWEEP_BATCH of them share a
+// pool, so integration runs over many characters at once. The FSM only
+// reads the pool's SC_CharacterTuning, which is switched to each instance's
+// own before its inputs and tick, while integration only needs the top
+// speeds. Instances are sorted by those, so runs sharing them integrate
+// together.
+//
+// Sweep file, one field of SC_CharacterTuning per line, '#' starts a
+// comment:
+//   FIELD VALUE               a fixed value
+//   FIELD FROM TO STEPS       STEPS evenly spaced values from FROM to TO
+// Fields not listed keep their default. integrateCharacters clamps velY to
+// yVelMax, so a yVelStart faster than that is cut down on the first tick.
+
+#define SWEEP_LINE_MAX    256
+#define SWEEP_MAX_CONFIGS (1 << 20)
+
+// Moves that haven't finished by then are reported as never finishing
+#define SWEEP_MAX_TICKS 1000
+
+// Instances run together in one pool
+#define SWEEP_BATCH 256
+
+// Below this many configurations the results are logged as well
+#define SWEEP_LOG_CONFIGS 32
+
+#define SWEEP_GROUND_Y REAL(600)
+
+#define SWEEP_FIELDS(X) \
+    X(xVelStart) \
+    X(xVelMax) \
+    X(xAccRun) \
+    X(xAccStop) \
+    X(yVelStart) \
+    X(yVelMax) \
+    X(yAcc) \
+    X(yVelStop)
+
+typedef enum SC_SweepField {
+#define SWEEP_FIELD_ID(name) SC_SWEEP_##name,
+    SWEEP_FIELDS(SWEEP_FIELD_ID)
+#undef SWEEP_FIELD_ID
+    SC_SWEEP_FIELD_TOTAL
+} SC_SweepField;
+
+static const char *sweepFieldNames[] = {
+#define SWEEP_FIELD_NAME(name) #name,
+    SWEEP_FIELDS(SWEEP_FIELD_NAME)
+#undef SWEEP_FIELD_NAME
+};
+
+typedef enum SC_SweepMove {
+    SC_SWEEP_JUMP,     // Standing jump with jump held
+    SC_SWEEP_HOP,      // Standing jump let go of on the next tick
+    SC_SWEEP_RUN,      // Run from standing to full speed, then let go
+    SC_SWEEP_RUN_JUMP, // Jump held, as soon as the run reaches full speed
+    SC_SWEEP_MOVE_TOTAL
+} SC_SweepMove;
+
+// Distances in px, times in ms from the input that started them. Anything
+// that didn't happen within SWEEP_MAX_TICKS is negative.
+typedef struct SC_SweepResult {
+    float jumpHeight;
+    float jumpPeakMs;
+    float jumpAirMs;
+    float hopHeight;
+    float hopAirMs;
+    float runUpDistance; // To full speed
+    float runUpMs;
+    float stopDistance;  // From full speed
+    float stopMs;
+    float runJumpDistance; // Covered in the air
+    float runJumpAirMs;
+} SC_SweepResult;
+
+// One swept field: its values are from + (to - from) * n / (steps - 1)
+typedef struct SC_SweepRange {
+    SC_SweepField field;
+    double from;
+    double to;
+    Uint32 steps;
+} SC_SweepRange;
+
+// Where an instance's moves are up to
+typedef struct SC_SweepProgress {
+    SC_Real jumpTop;
+    SC_Real hopTop;
+    SC_Real stopX;
+    SC_Real takeOffX;
+    Uint64 stopTick;
+    Uint64 takeOffTick;
+    bool done;
+} SC_SweepProgress;
+
+// Configuration `k` in the order instances are run
+typedef struct SC_SweepOrder {
+    SC_Real xVelMax;
+    SC_Real yVelMax;
+    Uint32 k;
+} SC_SweepOrder;
+
+typedef struct SC_SweepJob {
+    const SC_SweepOrder *order;
+    const SC_CharacterTuning *tunings;
+    SC_SweepResult *results;
+    SDL_AtomicInt failed;
+} SC_SweepJob;
+
+typedef struct SC_Sweep {
+    const char *path;
+    const char *csvPath;
+} SC_Sweep;
+
+SC_Sweep sweep = { 0 };
+
+static SC_Real *sweepField(SC_CharacterTuning *t, SC_SweepField f)
+{
+    switch (f) {
+#define SWEEP_FIELD_CASE(name) case SC_SWEEP_##name: return &t->name;
+    SWEEP_FIELDS(SWEEP_FIELD_CASE)
+#undef SWEEP_FIELD_CASE
+    default: return NULL;
+    }
+}
+
+static bool parseSweepLine(SC_SweepRange *ranges, Uint32 *numRanges, char *line, const char **error)
+{
+    char *comment = SDL_strchr(line, '#');
+    if (comment != NULL) {
+        *comment = '\0';
+    }
+
+    char word[16];
+    if (SDL_sscanf(line, "%15s", word) != 1) {
+        return true;
+    }
+
+    int f = 0;
+    while (f < SC_SWEEP_FIELD_TOTAL && SDL_strcmp(word, sweepFieldNames[f]) != 0) {
+        f++;
+    }
+    if (f == SC_SWEEP_FIELD_TOTAL) {
+        *error = "unknown field";
+        return false;
+    }
+    for (Uint32 n = 0; n < *numRanges; n++) {
+        if (ranges[n].field == (SC_SweepField) f) {
+            *error = "field listed twice";
+            return false;
+        }
+    }
+
+    SC_SweepRange r = { (SC_SweepField) f, 0.0, 0.0, 1 };
+    int steps = 1;
+    char extra;
+    int n = SDL_sscanf(line, " %*s %lf %lf %d %c", &r.from, &r.to, &steps, &extra);
+    if (n == 1) {
+        r.to = r.from;
+    } else if (n != 3 || steps < 2) {
+        *error = "expected: FIELD VALUE or FIELD FROM TO STEPS";
+        return false;
+    }
+    r.steps = (Uint32) steps;
+
+    ranges[(*numRanges)++] = r;
+    return true;
+}
+
+// Reads the sweep file into one range per listed field
+static bool loadSweep(const char *path, SC_SweepRange *ranges, Uint32 *numRanges)
+{
+    size_t length;
+    char *text = SDL_LoadFile(path, &length);
+    if (text == NULL) {
+        SDL_Log("Failed to load %s: %s", path, SDL_GetError());
+        return false;
+    }
+
+    char line[SWEEP_LINE_MAX];
+    int lineNumber = 0;
+    size_t pos = 0;
+    *numRanges = 0;
+
+    while (pos < length) {
+        size_t end = pos;
+        while (end < length && text[end] != '\n') {
+            end++;
+        }
+        lineNumber++;
+
+        size_t n = end - pos;
+        if (n >= sizeof(line)) {
+            SDL_Log("%s:%d: line too long", path, lineNumber);
+            SDL_free(text);
+            return false;
+        }
+        SDL_memcpy(line, text + pos, n);
+        line[n] = '\0';
+        pos = end + 1;
+
+        const char *error = NULL;
+        if (!parseSweepLine(ranges, numRanges, line, &error)) {
+            SDL_Log("%s:%d: %s", path, lineNumber, error);
+            SDL_free(text);
+            return false;
+        }
+    }
+
+    SDL_free(text);
+    return true;
+}
+
+// Configuration `k` counts through the ranges like digits, the last range
+// changing fastest
+static SC_CharacterTuning sweepTuning(const SC_SweepRange *ranges, Uint32 numRanges, Uint32 k)
+{
+    SC_CharacterTuning t = characterTuningDefault;
+
+    for (Uint32 n = numRanges; n-- > 0;) {
+        const SC_SweepRange *r = &ranges[n];
+        Uint32 step = k % r->steps;
+        k /= r->steps;
+
+        double v = r->steps > 1 ? r->from + (r->to - r->from) * step / (r->steps - 1) : r->from;
+        *sweepField(&t, r->field) = REAL(v);
+    }
+
+    return t;
+}
+
+static float sweepMs(Uint64 ticks)
+{
+    return (float) (ticks * FIXED_TICK_RATE);
+}
+
+// Inputs for one instance's characters, from `first`, before its tick is
+// simulated, like queued key events are
+static void sweepInputs(SC_Characters *c, Uint32 first, Uint64 tick, const SC_SweepResult *r, SC_SweepProgress *p)
+{
+    Uint64 now = tick * FIXED_TICK_RATE;
+
+    if (tick == 0) {
+        eventCharacter(c, first + SC_SWEEP_JUMP, SC_EVENT_JUMP, now, 0);
+        eventCharacter(c, first + SC_SWEEP_HOP, SC_EVENT_JUMP, now, 0);
+        eventCharacter(c, first + SC_SWEEP_RUN, SC_EVENT_RUN_START, now, CHARACTER_MOVE_RIGHT);
+        eventCharacter(c, first + SC_SWEEP_RUN_JUMP, SC_EVENT_RUN_START, now, CHARACTER_MOVE_RIGHT);
+    } else if (tick == 1) {
+        eventCharacter(c, first + SC_SWEEP_HOP, SC_EVENT_JUMP_STOP, now, 0);
+    }
+    if (r->runUpMs >= 0.0f && p->stopTick == 0) {
+        p->stopTick = tick;
+        p->stopX = c->posX[first + SC_SWEEP_RUN];
+        eventCharacter(c, first + SC_SWEEP_RUN, SC_EVENT_RUN_STOP, now, CHARACTER_MOVE_RIGHT);
+    }
+    if (p->takeOffTick == 0 && c->state[first + SC_SWEEP_RUN_JUMP] == SC_CHARACTER_RUN) {
+        p->takeOffTick = tick;
+        p->takeOffX = c->posX[first + SC_SWEEP_RUN_JUMP];
+        eventCharacter(c, first + SC_SWEEP_RUN_JUMP, SC_EVENT_JUMP, now, 0);
+    }
+}
+
+// Notes what one instance's moves got up to in tick `tick`. Times count the
+// tick just simulated.
+static void sweepRecord(const SC_Characters *c, Uint32 first, Uint64 tick, SC_SweepResult *r, SC_SweepProgress *p)
+{
+    Uint64 ticks = tick + 1;
+    const SC_Real *posX = c->posX + first;
+    const Uint8 *state = c->state + first;
+
+    p->jumpTop = SDL_min(p->jumpTop, c->posY[first + SC_SWEEP_JUMP]);
+    p->hopTop = SDL_min(p->hopTop, c->posY[first + SC_SWEEP_HOP]);
+
+    if (r->jumpPeakMs < 0.0f && state[SC_SWEEP_JUMP] == SC_CHARACTER_STAND_FALL) {
+        r->jumpPeakMs = sweepMs(ticks);
+    }
+    if (r->jumpAirMs < 0.0f && state[SC_SWEEP_JUMP] == SC_CHARACTER_STAND) {
+        r->jumpAirMs = sweepMs(ticks);
+        r->jumpHeight = REAL_TO_FLOAT(SWEEP_GROUND_Y - p->jumpTop);
+    }
+    if (r->hopAirMs < 0.0f && state[SC_SWEEP_HOP] == SC_CHARACTER_STAND) {
+        r->hopAirMs = sweepMs(ticks);
+        r->hopHeight = REAL_TO_FLOAT(SWEEP_GROUND_Y - p->hopTop);
+    }
+    if (r->runUpMs < 0.0f && state[SC_SWEEP_RUN] == SC_CHARACTER_RUN) {
+        r->runUpMs = sweepMs(ticks);
+        r->runUpDistance = REAL_TO_FLOAT(posX[SC_SWEEP_RUN]);
+    }
+    if (r->stopMs < 0.0f && p->stopTick > 0 && state[SC_SWEEP_RUN] == SC_CHARACTER_STAND) {
+        r->stopMs = sweepMs(ticks - p->stopTick);
+        r->stopDistance = REAL_TO_FLOAT(posX[SC_SWEEP_RUN] - p->stopX);
+    }
+    if (r->runJumpAirMs < 0.0f && p->takeOffTick > 0 && state[SC_SWEEP_RUN_JUMP] == SC_CHARACTER_RUN) {
+        r->runJumpAirMs = sweepMs(ticks - p->takeOffTick);
+        r->runJumpDistance = REAL_TO_FLOAT(posX[SC_SWEEP_RUN_JUMP] - p->takeOffX);
+    }
+
+    p->done = r->jumpAirMs >= 0.0f && r->hopAirMs >= 0.0f && r->stopMs >= 0.0f && r->runJumpAirMs >= 0.0f;
+}
+
+// Runs every move of `n` instances to the end, or to SWEEP_MAX_TICKS.
+// Finished instances are still integrated, so runs don't break up, but
+// their inputs and FSM are left alone.
+static void runSweepBatch(SC_Characters *c, const SC_SweepJob *job, const SC_SweepOrder *order, Uint32 n)
+{
+    SC_SweepProgress progress[SWEEP_BATCH];
+
+    clearCharacters(c);
+    for (Uint32 i = 0; i < n * SC_SWEEP_MOVE_TOTAL; i++) {
+        spawnCharacter(c);
+        c->posY[i] = SWEEP_GROUND_Y;
+        c->floorY[i] = SWEEP_GROUND_Y;
+        c->flags[i] = CHARACTER_FLAG_FACE_RIGHT;
+        c->state[i] = SC_CHARACTER_STAND;
+    }
+    for (Uint32 b = 0; b < n; b++) {
+        job->results[order[b].k] = (SC_SweepResult) { -1.0f, -1.0f, -1.0f, -1.0f, -1.0f, -1.0f, -1.0f, -1.0f, -1.0f, -1.0f, -1.0f };
+        progress[b] = (SC_SweepProgress) { SWEEP_GROUND_Y, SWEEP_GROUND_Y, 0, 0, 0, 0, false };
+    }
+
+    Uint32 numDone = 0;
+    for (Uint64 tick = 0; tick < SWEEP_MAX_TICKS && numDone < n; tick++) {
+        Uint64 now = tick * FIXED_TICK_RATE;
+
+        for (Uint32 b = 0; b < n; b++) {
+            if (!progress[b].done) {
+                c->tuning = job->tunings[order[b].k];
+                sweepInputs(c, b * SC_SWEEP_MOVE_TOTAL, tick, &job->results[order[b].k], &progress[b]);
+            }
+        }
+
+        for (Uint32 b = 0; b < n;) {
+            Uint32 e = b + 1;
+            while (e < n && order[e].xVelMax == order[b].xVelMax && order[e].yVelMax == order[b].yVelMax) {
+                e++;
+            }
+            integrateCharacters(c, b * SC_SWEEP_MOVE_TOTAL, e * SC_SWEEP_MOVE_TOTAL, FIXED_TICK_RATE, order[b].xVelMax, order[b].yVelMax);
+            b = e;
+        }
+
+        for (Uint32 b = 0; b < n; b++) {
+            if (progress[b].done) {
+                continue;
+            }
+            Uint32 first = b * SC_SWEEP_MOVE_TOTAL;
+            c->tuning = job->tunings[order[b].k];
+            tickCharactersDirect(c, first, first + SC_SWEEP_MOVE_TOTAL, FIXED_TICK_RATE, now + FIXED_TICK_RATE);
+            sweepRecord(c, first, tick, &job->results[order[b].k], &progress[b]);
+            numDone += progress[b].done;
+        }
+    }
+}
+
+// Each chunk of instances runs in a pool of its own, reused from one batch
+// to the next
+static void sweepJob(void *data, Uint32 begin, Uint32 end)
+{
+    SC_SweepJob *job = data;
+    Uint32 capacity = SWEEP_BATCH * SC_SWEEP_MOVE_TOTAL;
+
+    SC_Arena arena;
+    SC_Characters c;
+    if (!initArena(&arena, "sweep", layoutCharacters(NULL, NULL, capacity))
+        || !initCharacters(&c, &arena, capacity)) {
+        destroyArena(&arena);
+        SDL_SetAtomicInt(&job->failed, 1);
+        return;
+    }
+
+    for (Uint32 q = begin; q < end; q += SWEEP_BATCH) {
+        runSweepBatch(&c, job, job->order + q, SDL_min(end - q, SWEEP_BATCH));
+    }
+
+    destroyArena(&arena);
+}
+
+// Instances sharing top speeds next to each other, otherwise in order
+static int compareSweepOrder(const void *a, const void *b)
+{
+    const SC_SweepOrder *x = a;
+    const SC_SweepOrder *y = b;
+    if (x->xVelMax != y->xVelMax) {
+        return x->xVelMax < y->xVelMax ? -1 : 1;
+    }
+    if (x->yVelMax != y->yVelMax) {
+        return x->yVelMax < y->yVelMax ? -1 : 1;
+    }
+    return (x->k > y->k) - (x->k < y->k);
+}
+
+static void formatSweepValue(char *out, size_t size, float v)
+{
+    if (v < 0.0f) {
+        SDL_strlcpy(out, "-", size);
+    } else {
+        SDL_snprintf(out, size, "%.1f", (double) v);
+    }
+}
+
+static void logSweepResult(Uint32 k, const SC_SweepResult *r)
+{
+    const float values[] = {
+        r->jumpHeight, r->jumpPeakMs, r->jumpAirMs, r->hopHeight, r->hopAirMs,
+        r->runUpDistance, r->runUpMs, r->stopDistance, r->stopMs, r->runJumpDistance,
+    };
+    char text[SDL_arraysize(values)][16];
+    for (Uint32 n = 0; n < SDL_arraysize(values); n++) {
+        formatSweepValue(text[n], sizeof(text[n]), values[n]);
+    }
+
+    SDL_Log("%6u %7s %7s %7s %7s %7s %7s %7s %7s %7s %7s", k,
+        text[0], text[1], text[2], text[3], text[4], text[5], text[6], text[7], text[8], text[9]);
+}
+
+static bool writeSweepCsv(const char *path, const SC_CharacterTuning *tunings, const SC_SweepResult *results, Uint32 numConfigs)
+{
+    SDL_IOStream *out = SDL_IOFromFile(path, "w");
+    if (out == NULL) {
+        SDL_Log("Failed to open %s: %s", path, SDL_GetError());
+        return false;
+    }
+
+    bool ok = true;
+    for (int f = 0; f < SC_SWEEP_FIELD_TOTAL; f++) {
+        ok = ok && SDL_IOprintf(out, "%s,", sweepFieldNames[f]) > 0;
+    }
+    ok = ok && SDL_IOprintf(out, "jumpHeight,jumpPeakMs,jumpAirMs,hopHeight,hopAirMs,"
+        "runUpDistance,runUpMs,stopDistance,stopMs,runJumpDistance,runJumpAirMs\n") > 0;
+
+    for (Uint32 k = 0; k < numConfigs && ok; k++) {
+        SC_CharacterTuning t = tunings[k];
+        for (int f = 0; f < SC_SWEEP_FIELD_TOTAL; f++) {
+            ok = ok && SDL_IOprintf(out, "%g,", (double) REAL_TO_FLOAT(*sweepField(&t, (SC_SweepField) f))) > 0;
+        }
+        const SC_SweepResult *r = &results[k];
+        ok = ok && SDL_IOprintf(out, "%g,%g,%g,%g,%g,%g,%g,%g,%g,%g,%g\n",
+            (double) r->jumpHeight, (double) r->jumpPeakMs, (double) r->jumpAirMs,
+            (double) r->hopHeight, (double) r->hopAirMs,
+            (double) r->runUpDistance, (double) r->runUpMs,
+            (double) r->stopDistance, (double) r->stopMs,
+            (double) r->runJumpDistance, (double) r->runJumpAirMs) > 0;
+    }
+
+    ok = SDL_CloseIO(out) && ok;
+    if (!ok) {
+        SDL_Log("Failed to write %s: %s", path, SDL_GetError());
+    }
+    return ok;
+}
+
+// --sweep
+bool runSweep(const char *path, const char *csvPath, SC_Workers *workers)
+{
+    SC_SweepRange ranges[SC_SWEEP_FIELD_TOTAL];
+    Uint32 numRanges;
+    if (!loadSweep(path, ranges, &numRanges)) {
+        return false;
+    }
+
+    Uint64 numConfigs = 1;
+    for (Uint32 n = 0; n < numRanges; n++) {
+        numConfigs *= ranges[n].steps;
+        if (numConfigs > SWEEP_MAX_CONFIGS) {
+            SDL_Log("%s: more than %d configurations", path, SWEEP_MAX_CONFIGS);
+            return false;
+        }
+    }
+
+    SC_CharacterTuning *tunings = SDL_malloc(numConfigs * sizeof(SC_CharacterTuning));
+    SC_SweepOrder *order = SDL_malloc(numConfigs * sizeof(SC_SweepOrder));
+    SC_SweepJob job = {
+        .order = order,
+        .tunings = tunings,
+        .results = SDL_malloc(numConfigs * sizeof(SC_SweepResult)),
+    };
+    if (tunings == NULL || order == NULL || job.results == NULL) {
+        SDL_Log("Failed to allocate %u configurations", (Uint32) numConfigs);
+        SDL_free(tunings);
+        SDL_free(order);
+        SDL_free(job.results);
+        return false;
+    }
+
+    for (Uint32 k = 0; k < numConfigs; k++) {
+        tunings[k] = sweepTuning(ranges, numRanges, k);
+        order[k] = (SC_SweepOrder) { tunings[k].xVelMax, tunings[k].yVelMax, k };
+    }
+    SDL_qsort(order, numConfigs, sizeof(SC_SweepOrder), compareSweepOrder);
+    SDL_SetAtomicInt(&job.failed, 0);
+
+    selectIntegrateKernel();
+
+    Uint64 perf = SDL_GetPerformanceCounter();
+    runWorkers(workers, sweepJob, &job, (Uint32) numConfigs, 1);
+    perf = SDL_GetPerformanceCounter() - perf;
+    double seconds = (double) perf / (double) SDL_GetPerformanceFrequency();
+
+    bool ok = SDL_GetAtomicInt(&job.failed) == 0;
+    if (!ok) {
+        SDL_Log("Failed to allocate sweep instances");
+    } else {
+        SDL_Log("Swept %u configurations on %d threads in %.3f s, %.0f instances per second",
+            (Uint32) numConfigs, workers != NULL ? workers->numThreads : 1, seconds,
+            seconds > 0.0 ? (double) numConfigs / seconds : 0.0);
+
+        if (numConfigs <= SWEEP_LOG_CONFIGS) {
+            SDL_Log("%6s %7s %7s %7s %7s %7s %7s %7s %7s %7s %7s", "config",
+                "jump px", "peak ms", "air ms", "hop px", "air ms", "run px", "ms", "stop px", "ms", "leap px");
+            for (Uint32 k = 0; k < numConfigs; k++) {
+                logSweepResult(k, &job.results[k]);
+            }
+        }
+
+        if (csvPath != NULL) {
+            ok = writeSweepCsv(csvPath, tunings, job.results, (Uint32) numConfigs);
+        } else if (numConfigs > SWEEP_LOG_CONFIGS) {
+            SDL_Log("Pass --sweep-csv FILE for the results");
+        }
+    }
+
+    SDL_free(tunings);
+    SDL_free(order);
+    SDL_free(job.results);
+    return ok;
+}
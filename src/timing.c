@@ -0,0 +1,162 @@
+#include <SDL3/SDL.h>
+
+// Per-phase frame timing. Each frame's phase durations go into a fixed ring
+// of the last SC_TIMING_FRAMES frames, so timing costs one performance
+// counter read per phase and never allocates.
+
+#define SC_TIMING_FRAMES 1024
+
+// Sorting every phase every frame would show up in the numbers it reports
+#define SC_TIMING_STATS_EVERY 30
+
+typedef enum SC_TimingPhase {
+    SC_PHASE_TICK,
+    SC_PHASE_CLEAR,
+    SC_PHASE_BACKGROUND,
+    SC_PHASE_CHARACTERS,
+    SC_PHASE_TEXT,
+    SC_PHASE_PRESENT,
+    SC_PHASE_TOTAL,
+} SC_TimingPhase;
+
+static const char *timingPhaseNames[SC_PHASE_TOTAL] = {
+    "tick",
+    "clear",
+    "background",
+    "characters",
+    "text",
+    "present",
+};
+
+typedef struct SC_TimingStats {
+    float p50;
+    float p99;
+    float max;
+} SC_TimingStats;
+
+typedef struct SC_Timing {
+    bool overlay;
+    const char *csvPath;
+
+    Uint64 frame; // Frames timed so far, the ring holds the last SC_TIMING_FRAMES
+    Uint64 last;
+    Uint32 samples[SC_TIMING_FRAMES][SC_PHASE_TOTAL]; // Performance counter ticks
+    SC_TimingStats stats[SC_PHASE_TOTAL]; // In ms
+} SC_Timing;
+
+SC_Timing timing = {
+    .overlay = false,
+    .csvPath = NULL,
+};
+
+void timingBeginFrame()
+{
+    timing.last = SDL_GetPerformanceCounter();
+}
+
+// Charges the time since the previous mark to `phase`
+void timingMark(SC_TimingPhase phase)
+{
+    Uint64 now = SDL_GetPerformanceCounter();
+    Uint64 elapsed = now - timing.last;
+
+    timing.samples[timing.frame % SC_TIMING_FRAMES][phase] = (Uint32) SDL_min(elapsed, SDL_MAX_UINT32);
+    timing.last = now;
+}
+
+static int compareSamples(const void *a, const void *b)
+{
+    Uint32 x = *(const Uint32 *) a;
+    Uint32 y = *(const Uint32 *) b;
+    return (x > y) - (x < y);
+}
+
+static void timingUpdateStats()
+{
+    static Uint32 sorted[SC_TIMING_FRAMES];
+    Uint32 n = (Uint32) SDL_min(timing.frame, SC_TIMING_FRAMES);
+    double ms = 1e3 / (double) SDL_GetPerformanceFrequency();
+
+    if (n == 0) {
+        return;
+    }
+
+    for (int phase = 0; phase < SC_PHASE_TOTAL; phase++) {
+        for (Uint32 f = 0; f < n; f++) {
+            sorted[f] = timing.samples[f][phase];
+        }
+        SDL_qsort(sorted, n, sizeof(Uint32), compareSamples);
+
+        timing.stats[phase].p50 = (float) (sorted[n / 2] * ms);
+        timing.stats[phase].p99 = (float) (sorted[(n - 1) * 99 / 100] * ms);
+        timing.stats[phase].max = (float) (sorted[n - 1] * ms);
+    }
+}
+
+void timingEndFrame()
+{
+    timing.frame++;
+
+    if (timing.overlay && timing.frame % SC_TIMING_STATS_EVERY == 0) {
+        timingUpdateStats();
+    }
+}
+
+// Drawn at 2x scale, to the right of the HUD
+void timingRenderOverlay(SDL_Renderer *renderer)
+{
+    if (!timing.overlay) {
+        return;
+    }
+
+    SDL_SetRenderScale(renderer, 2.0f, 2.0f);
+    SDL_SetRenderDrawColor(renderer, 160, 220, 255, SDL_ALPHA_OPAQUE);
+    SDL_RenderDebugText(renderer, 165.0f, 8.0f, "ms           p50    p99    max");
+    for (int phase = 0; phase < SC_PHASE_TOTAL; phase++) {
+        SDL_RenderDebugTextFormat(renderer, 165.0f, 20.0f + 10.0f * phase, "%-10s %6.3f %6.3f %6.3f",
+            timingPhaseNames[phase],
+            timing.stats[phase].p50,
+            timing.stats[phase].p99,
+            timing.stats[phase].max);
+    }
+    SDL_SetRenderScale(renderer, 1.0f, 1.0f);
+}
+
+// Writes the frames still in the ring, oldest first, in microseconds
+bool timingWriteCSV()
+{
+    if (timing.csvPath == NULL) {
+        return true;
+    }
+
+    SDL_IOStream *io = SDL_IOFromFile(timing.csvPath, "w");
+    if (io == NULL) {
+        SDL_Log("Failed to open %s: %s", timing.csvPath, SDL_GetError());
+        return false;
+    }
+
+    double us = 1e6 / (double) SDL_GetPerformanceFrequency();
+    Uint64 first = timing.frame > SC_TIMING_FRAMES ? timing.frame - SC_TIMING_FRAMES : 0;
+
+    SDL_IOprintf(io, "frame");
+    for (int phase = 0; phase < SC_PHASE_TOTAL; phase++) {
+        SDL_IOprintf(io, ",%s_us", timingPhaseNames[phase]);
+    }
+    SDL_IOprintf(io, "\n");
+
+    for (Uint64 f = first; f < timing.frame; f++) {
+        SDL_IOprintf(io, "%" SDL_PRIu64, f);
+        for (int phase = 0; phase < SC_PHASE_TOTAL; phase++) {
+            SDL_IOprintf(io, ",%.3f", timing.samples[f % SC_TIMING_FRAMES][phase] * us);
+        }
+        SDL_IOprintf(io, "\n");
+    }
+
+    if (!SDL_CloseIO(io)) {
+        SDL_Log("Failed to write %s: %s", timing.csvPath, SDL_GetError());
+        return false;
+    }
+
+    SDL_Log("Wrote %" SDL_PRIu64 " frames of timings to %s", timing.frame - first, timing.csvPath);
+    return true;
+}
@@ -3,23 +3,309 @@
 #include "fsm.h"
 #include <SDL3/SDL.h>
 
+// Character physics runs on SC_Real. Building with -DSC_FIXED_POINT makes it
+// Q16.16 fixed point, which gives bit-identical results on every compiler,
+// optimization level and CPU. Otherwise it's float. REAL() converts a
+// constant, REAL_TO_FLOAT() a value for rendering. REAL_TO_INT() drops the
+// fraction, which only rounds the same way in both builds for values >= 0.
+#ifdef SC_FIXED_POINT
+typedef Sint32 SC_Real;
+#define SC_REAL_FRACTION_BITS 16
+#define REAL(x) ((SC_Real) ((x) * (1 << SC_REAL_FRACTION_BITS) + ((x) < 0 ? -0.5 : 0.5)))
+#define REAL_TO_FLOAT(r) ((float) (r) * (1.0f / (1 << SC_REAL_FRACTION_BITS)))
+#define REAL_ABS(r) SDL_abs(r)
+#define REAL_TO_INT(r) ((int) ((r) >> SC_REAL_FRACTION_BITS))
+#define REAL_FROM_INT(n) ((SC_Real) ((n) * (1 << SC_REAL_FRACTION_BITS)))
+#else
+typedef float SC_Real;
+#define REAL(x) ((float) (x))
+#define REAL_TO_FLOAT(r) (r)
+#define REAL_ABS(r) SDL_fabsf(r)
+#define REAL_TO_INT(r) ((int) (r))
+#define REAL_FROM_INT(n) ((float) (n))
+#endif
+
+// Linear allocator, see arena.c. Allocations start on SC_ARENA_ALIGN
+// boundaries, same as the pool arrays need.
+#define SC_ARENA_ALIGN 64
+
+typedef struct SC_ArenaChunk SC_ArenaChunk;
+
+typedef struct SC_Arena {
+    const char *name;
+    SC_ArenaChunk *chunk; // Newest, allocations come from here
+    size_t used;          // Since the last reset, over every chunk
+    size_t size;          // Of every chunk
+    size_t highWater;     // Most ever used at once
+    Uint32 numChunks;
+    Uint64 heapAllocs;    // Chunks ever allocated
+} SC_Arena;
+
+// Where an arena was at, to give back what was allocated after it
+typedef struct SC_ArenaMark {
+    SC_ArenaChunk *chunk;
+    size_t chunkUsed;
+    size_t used;
+} SC_ArenaMark;
+
 #define CHARACTER_FLAG_FACE_RIGHT 0b01
 #define CHARACTER_FLAG_FACE_LEFT  0b10
 
-typedef struct SC_Character {
-    SDL_FPoint pos;
-    SDL_FPoint vel;
-    SDL_FPoint acc;
-    SC_Character_State state;
-    Uint8 flags;
-} SC_Character;
+// Characters are stored as a structure of arrays so the integration step can
+// run over every character with SIMD. All arrays live in one allocation and
+// each one starts on a SC_CHARACTERS_ALIGN boundary.
+#define SC_CHARACTERS_ALIGN 64
+
+// A generational handle to a character: slot index in the low 32 bits,
+// generation in the high 32 bits. Generations start at 1, so a zeroed handle
+// is never valid.
+typedef Uint64 SC_Handle;
+
+#define SC_HANDLE_NONE 0
+#define SC_SLOT_NONE   0xFFFFFFFF
+
+// Movement constants shared by every character in a pool, in px and ms. See
+// fsm-character.c for the defaults.
+typedef struct SC_CharacterTuning {
+    SC_Real xVelStart; // Speed a run starts at
+    SC_Real xVelMax;
+    SC_Real xAccRun;
+    SC_Real xAccStop;
+    SC_Real yVelStart; // Jump speed, negative is up
+    SC_Real yVelMax;   // Fastest fall
+    SC_Real yAcc;
+    SC_Real yVelStop;  // Letting go of jump caps the rise to this
+} SC_CharacterTuning;
+
+// Live characters are dense in [0, count) and move when another character is
+// despawned, so hold on to a SC_Handle rather than an index. Each slot maps a
+// handle to its current dense index; free slots are chained through slotDense.
+typedef struct SC_Characters {
+    SC_Real *posX;
+    SC_Real *posY;
+    SC_Real *velX;
+    SC_Real *velY;
+    SC_Real *accX;
+    SC_Real *accY;
+    SC_Real *prevX; // Position before the last step, only kept for rendering
+    SC_Real *prevY;
+    SC_Real *floorY; // Top of what's below the character, see computeFloors
+    Uint8 *state; // SC_Character_State
+    Uint8 *flags;
+    Uint32 *denseSlot;
+    Uint32 *slotDense;
+    Uint32 *slotGen;
+    Uint16 *wakeIn; // Predicted dispatch: ticks until the state's tick conditions can next be met
+    Uint32 *schedule; // Indices of the active characters, then the sleeping ones, see wakeCharacter
+    Uint32 *scheduledAt; // Where each character is in schedule
+    Uint32 count;
+    Uint32 numActive;
+    Uint32 numSorted; // schedule[0, numSorted) is in storage order, characters woken since come after
+    Uint32 capacity;
+    Uint32 numSlots;
+    Uint32 freeSlot;
+    SC_CharacterTuning tuning;
+    SC_Arena *arena; // The arrays come from here, growing leaves the old ones behind
+} SC_Characters;
+
+// Enemies come out of the level's pipes, walk along the platforms and wrap
+// around the sides of the playfield. Like characters they're a structure of
+// arrays in one aligned block, but the pool has a fixed capacity: spawning
+// appends, and enemies that are gone get compacted out at the end of the
+// tick. Nothing holds on to an enemy between ticks, so there are no handles.
+typedef struct SC_Enemies {
+    SC_Real *posX;
+    SC_Real *posY;
+    SC_Real *velX;
+    SC_Real *velY;
+    SC_Real *floorY;
+    SC_Real *speed; // Walking speed, goes up every time it recovers
+    Uint16 *timer;  // Ticks left flipped or recovering
+    Uint8 *state;   // SC_Enemy_State
+    Uint8 *kind;
+    Uint8 *flags;   // CHARACTER_FLAG_FACE_*
+    Uint32 count;
+    Uint32 capacity;
+    SC_Arena *arena;
+
+    // Spawning
+    Uint32 nextScheduled; // Next entry of the level's schedule
+    Uint32 numSpawned;
+    Uint32 dropped; // Spawns skipped with the pool full
+
+    Uint64 totalFlipped;
+    Uint64 totalKilled;
+} SC_Enemies;
+
+typedef enum SC_DispatchMode {
+    SC_DISPATCH_DIRECT, // One FSM tick call per character, in storage order
+    SC_DISPATCH_BATCH,  // Characters grouped by state, see tickCharactersBatched
+    SC_DISPATCH_PREDICTED, // Only ticked when a transition can be due, see motion.c
+} SC_DispatchMode;
+
+// Character indices grouped by state for batched dispatch. Bucket `s` is
+// order[bucketStart[s]] up to order[bucketStart[s + 1]]. The grouping is kept
+// between ticks and only characters whose state changed get moved.
+typedef struct SC_Dispatch {
+    Uint32 *order;
+    Uint32 *where; // Position of each character in order
+    Uint8 *filed;  // State each character is filed under in order
+    Uint32 numTransitions;
+    Uint32 count; // Number of characters filed
+    Uint32 capacity;
+    SC_Arena *arena;
+    Uint32 ticksSinceGroup;
+    Uint32 bucketStart[SC_CHARACTER_MOVE_STATE_TOTAL + 1];
+} SC_Dispatch;
+
+typedef struct SC_Workers SC_Workers;
+
+// The playfield is split into a uniform grid of square cells for collision
+// broadphase. Anything outside it is filed under the nearest edge cell.
+#define SC_PLAYFIELD_WIDTH  960
+#define SC_PLAYFIELD_HEIGHT 720
+#define SC_GRID_CELL_SIZE   64
+#define SC_GRID_COLS  ((SC_PLAYFIELD_WIDTH + SC_GRID_CELL_SIZE - 1) / SC_GRID_CELL_SIZE)
+#define SC_GRID_ROWS  ((SC_PLAYFIELD_HEIGHT + SC_GRID_CELL_SIZE - 1) / SC_GRID_CELL_SIZE)
+#define SC_GRID_CELLS (SC_GRID_COLS * SC_GRID_ROWS)
+
+// Level geometry is in whole pixels, so one level file works with either
+// kind of SC_Real. See level.c for the file format.
+
+// A one-way platform: characters pass through it going up and land on it
+// coming down
+typedef struct SC_Platform {
+    Sint32 left;
+    Sint32 right;
+    Sint32 top;
+} SC_Platform;
+
+typedef struct SC_SpawnPoint {
+    Sint32 x;
+    Sint32 y;
+} SC_SpawnPoint;
+
+// Where enemies come out, and which way they head
+typedef struct SC_Pipe {
+    Sint32 x;
+    Sint32 y;
+    Sint32 dir; // 1 right, -1 left
+} SC_Pipe;
+
+typedef struct SC_PipeSpawn {
+    Uint32 tick;
+    Uint16 pipe;
+    Uint16 kind;
+} SC_PipeSpawn;
+
+// A level, read in place from its file. The ground at groundY is not a
+// platform, it runs forever in both directions. Each platform is filed under
+// the grid cells along its top: cell k holds cellPlatforms[cellStart[k]] up
+// to cellStart[k + 1].
+typedef struct SC_Level {
+    const SC_Platform *platforms;
+    const Uint16 *cellPlatforms;
+    const Uint32 *cellStart; // SC_GRID_CELLS + 1 entries
+    const Uint8 *nextRow;    // First row at or below cell k's with a platform in its column
+    const SC_SpawnPoint *spawns; // The player starts at the first one
+    const SC_Pipe *pipes;
+    const SC_PipeSpawn *schedule; // Ordered by tick
+    Uint32 numPlatforms;
+    Uint32 numSpawns;
+    Uint32 numPipes;
+    Uint32 numScheduled;
+    SC_Real groundY;
+    Uint32 checksum; // Of the whole file, replays check it
+
+    void *data;
+    size_t size;
+    bool mapped; // data is a file mapping rather than SDL_malloc'd
+} SC_Level;
+
+typedef enum SC_ContactType {
+    SC_CONTACT_BUMP,
+    SC_CONTACT_STOMP, // The player came down on top of the other character
+} SC_ContactType;
+
+typedef struct SC_Contact {
+    Uint32 player;
+    Uint32 other;
+    SC_ContactType type;
+} SC_Contact;
+
+// Character indices filed by grid cell, kept between ticks the same way as
+// SC_Dispatch: cell k is order[cellStart[k]] up to order[cellStart[k + 1]].
+// Only characters that changed cell get moved.
+typedef struct SC_Collisions {
+    Uint32 *order;
+    Uint32 *where; // Position of each character in order
+    Uint16 *filed; // Cell each character is filed under in order
+    Uint32 count;  // Number of characters filed
+    Uint32 capacity;
+    SC_Arena *arena;
+    Uint32 cellStart[SC_GRID_CELLS + 1];
+
+    // Player contacts found in this step, by player, then ordered by the
+    // other index. They're step scratch, gone once the step ends.
+    SC_Contact *contacts;
+    Uint32 numContacts;
+    Uint64 totalBumps;
+    Uint64 totalStomps;
+} SC_Collisions;
+
+// Must be a power of two
+#define SC_INPUT_QUEUE_SIZE 256
+
+typedef struct SC_InputEvent {
+    Uint64 timestamp; // ns, on the SDL_GetTicksNS clock
+    Uint32 event;
+    Uint32 keyFlag;
+} SC_InputEvent;
+
+// Key events waiting for the fixed step they happened in. One thread pushes
+// (SDL_AppEvent) and one pops (tick), so head and tail each have a single
+// writer and no lock is needed. They count up forever and wrap around.
+typedef struct SC_InputQueue {
+    SC_InputEvent events[SC_INPUT_QUEUE_SIZE];
+    SDL_AtomicU32 head; // Next event to pop, only written by the consumer
+    SDL_AtomicU32 tail; // Next slot to push into, only written by the producer
+    Uint32 dropped;
+} SC_InputQueue;
+
+// Players are the first characters spawned, each steered by its own keys
+#define SC_MAX_PLAYERS 2
 
 typedef struct SC_AppState {
-    SC_Character *characters;
+    SC_Arena arena; // Everything below, and the app state itself
+    SC_Arena frame; // Scratch, given back after every step and reset every frame
+    SC_Characters characters;
+    SC_Enemies enemies;
+    SC_Dispatch dispatch;
+    SC_DispatchMode dispatchMode;
+    SC_Collisions collisions;
+    const SC_Level *level; // Not owned
+    SC_Workers *workers; // Not owned, NULL ticks on the calling thread only
+    SC_Handle players[SC_MAX_PLAYERS];
+    Uint32 numPlayers;
+    Uint32 numStartCharacters;
+    Uint32 numArenaEnemies; // Pipes keep this many enemies out, 0 follows the level's schedule
     Uint64 prevTick;
     Uint64 msAccum;
-    Uint32 keysDown;
-    Uint8 numCharacters;
+    Uint64 tickCount;
+    Uint64 activeTicks;   // Active characters summed over every tick
+    Uint64 sleepingTicks; // Same for sleeping ones
+    Uint32 keysDown[SC_MAX_PLAYERS];
+    bool interpolate; // Keep previous positions so rendering can interpolate
+
+    SC_InputQueue input;
+
+    // Called after every fixed step, used to record replays
+    void (*onStep)(struct SC_AppState *s, void *data);
+    void *onStepData;
+
+    // Called for each queued input as tick() applies it, used to record
+    // replays
+    void (*onInput)(Uint64 event, Uint32 keyFlag);
 } SC_AppState;
 
 #endif
@@ -0,0 +1,152 @@
+#include <SDL3/SDL.h>
+#include "types.h"
+
+// A fixed pool of SDL threads that split a range of elements into chunks.
+// The calling thread works on chunks too, and runWorkers only returns once
+// every chunk is done. Chunks are claimed from an atomic counter, so which
+// thread runs a chunk varies, but a chunk's result must not depend on that.
+
+// Chunk boundaries are kept on multiples of this so no two threads write to
+// the same cache line of any SC_Characters or SC_Enemies array. Jobs have to
+// split storage for that to hold, not a list of indices into it.
+#define SC_WORKERS_CHUNK_ALIGN 64
+
+typedef void (*SC_JobFn)(void *data, Uint32 begin, Uint32 end);
+
+typedef struct SC_Workers {
+    SDL_Thread **threads;
+    SDL_Semaphore *start;
+    SDL_Semaphore *done;
+    int numThreads; // Including the calling thread
+    bool quit;
+
+    SC_JobFn fn;
+    void *data;
+    Uint32 count;
+    Uint32 chunk;
+    Uint32 numChunks;
+    SDL_AtomicInt nextChunk;
+} SC_Workers;
+
+static void runChunks(SC_Workers *w)
+{
+    for (;;) {
+        Uint32 k = (Uint32) SDL_AddAtomicInt(&w->nextChunk, 1);
+        if (k >= w->numChunks) {
+            break;
+        }
+
+        Uint32 begin = k * w->chunk;
+        Uint32 end = SDL_min(begin + w->chunk, w->count);
+        w->fn(w->data, begin, end);
+    }
+}
+
+static int workerMain(void *data)
+{
+    SC_Workers *w = data;
+
+    for (;;) {
+        SDL_WaitSemaphore(w->start);
+        if (w->quit) {
+            break;
+        }
+
+        runChunks(w);
+        SDL_SignalSemaphore(w->done);
+    }
+
+    return 0;
+}
+
+// numThreads counts the calling thread, 0 means one per logical core
+SC_Workers *createWorkers(int numThreads)
+{
+    if (numThreads <= 0) {
+        numThreads = SDL_GetNumLogicalCPUCores();
+    }
+    if (numThreads < 1) {
+        numThreads = 1;
+    }
+
+    SC_Workers *w = SDL_calloc(1, sizeof(SC_Workers));
+    if (w == NULL) {
+        return NULL;
+    }
+
+    w->start = SDL_CreateSemaphore(0);
+    w->done = SDL_CreateSemaphore(0);
+    w->threads = SDL_calloc(numThreads, sizeof(SDL_Thread *));
+    if (w->start == NULL || w->done == NULL || w->threads == NULL) {
+        SDL_DestroySemaphore(w->start);
+        SDL_DestroySemaphore(w->done);
+        SDL_free(w->threads);
+        SDL_free(w);
+        return NULL;
+    }
+
+    w->numThreads = 1;
+    for (int i = 1; i < numThreads; i++) {
+        w->threads[i] = SDL_CreateThread(workerMain, "SC_Worker", w);
+        if (w->threads[i] == NULL) {
+            SDL_Log("Failed to create worker thread: %s", SDL_GetError());
+            break;
+        }
+        w->numThreads++;
+    }
+
+    return w;
+}
+
+void destroyWorkers(SC_Workers *w)
+{
+    if (w == NULL) {
+        return;
+    }
+
+    w->quit = true;
+    for (int i = 1; i < w->numThreads; i++) {
+        SDL_SignalSemaphore(w->start);
+    }
+    for (int i = 1; i < w->numThreads; i++) {
+        SDL_WaitThread(w->threads[i], NULL);
+    }
+
+    SDL_DestroySemaphore(w->start);
+    SDL_DestroySemaphore(w->done);
+    SDL_free(w->threads);
+    SDL_free(w);
+}
+
+// Calls fn over [0, count) in chunks of at least `grain` elements. Ranges too
+// small to be worth waking the pool for run inline.
+void runWorkers(SC_Workers *w, SC_JobFn fn, void *data, Uint32 count, Uint32 grain)
+{
+    if (w == NULL || w->numThreads == 1 || count <= grain) {
+        fn(data, 0, count);
+        return;
+    }
+
+    // A few chunks per thread evens out threads that get descheduled
+    Uint32 chunk = count / (w->numThreads * 4);
+    chunk = SDL_max(chunk, grain);
+    chunk = (chunk + SC_WORKERS_CHUNK_ALIGN - 1) & ~(Uint32) (SC_WORKERS_CHUNK_ALIGN - 1);
+
+    w->fn = fn;
+    w->data = data;
+    w->count = count;
+    w->chunk = chunk;
+    w->numChunks = (count + chunk - 1) / chunk;
+    SDL_SetAtomicInt(&w->nextChunk, 0);
+
+    int helpers = SDL_min(w->numThreads - 1, (int) w->numChunks - 1);
+    for (int i = 0; i < helpers; i++) {
+        SDL_SignalSemaphore(w->start);
+    }
+
+    runChunks(w);
+
+    for (int i = 0; i < helpers; i++) {
+        SDL_WaitSemaphore(w->done);
+    }
+}